@@ -5,265 +5,854 @@
 #include "piece.h"      // For BoardState, Piece, PIECE_CHARS, square_to_algebraic
 #include "bitboard.h"   // For various constants if needed by included headers
 #include "ttable.h"     // For Transposition Table
+#include "move_ordering.h" // For killer, history and countermove tables
+#include "attack_tables.h" // For the step tables the den approach squares are built from
 #include <vector>
+#include <array>        // For the fixed-size root move ordering buffer
 #include <algorithm>    // For std::max, std::min, std::sort, std::find, std::rotate
 #include <limits>       // For std::numeric_limits
 #include <iostream>     // For AI thinking debug output
 #include <chrono>       // For timing
+#include <atomic>       // For the stop flag shared by the search threads
+#include <thread>       // For Lazy SMP helper threads
+#include <random>       // For perturbing the root move order of helper threads
+#include <memory>       // For the per-thread move ordering tables
+#include <cmath>        // For std::log (late move reduction table)
 
-// Applies a move to a given board state and returns the new state.
-BoardState make_move_on_copy(const BoardState& current_board_state, const Move& move) {
-    BoardState next_state = current_board_state; 
-    if (move.from_sq == -1 || move.to_sq == -1) { 
-        // This should ideally not be reached if move generation is correct
-        // and find_best_ai_move handles empty move lists.
-        std::cerr << "AI Error: make_move_on_copy called with invalid move (" << move.to_string() << ")" << std::endl;
-        // To prevent crashes, ensure next_state is still somewhat valid or throw.
-        // For now, it returns a copy of the original state, which might lead to AI re-evaluating it.
-        return next_state; 
-    }
-    next_state.apply_move(move); // apply_move handles piece removal, movement, side_to_move, and hash
-    return next_state;
+// --- Shared State of the running search (set up by find_best_ai_move) ---
+// All search threads read these; only atomics are written while the threads run.
+namespace {
+    using SearchClock = std::chrono::steady_clock;
+
+    const long long TIME_CHECK_INTERVAL_NODES = 1024; // Must be a power of two
+
+    std::atomic<bool> search_deadline_armed(false); // Armed by the main thread after depth 1
+    SearchClock::time_point search_hard_deadline;   // Written before the threads start
+    std::atomic<bool> search_stop(false);           // Deadline passed or main thread done; unwinds every thread
+    bool search_use_null_move = true;               // From SearchLimits, written before the threads start
+    bool search_use_late_move_reductions = true;    // From SearchLimits, written before the threads start
+    bool search_use_futility_pruning = true;        // From SearchLimits, written before the threads start
+
+    // How often the frontier pruning rules fired on this thread in the current search.
+    // Reset and read by iterative_deepening, which hands them to its SearchThread.
+    struct PruningCounters {
+        long long futility_prunes; // Quiet moves skipped by futility pruning
+        long long razor_prunes;    // Nodes answered by quiescence search through razoring
+    };
+    thread_local PruningCounters pruning_counters = {0, 0};
+
+    inline bool search_stopped() {
+        return search_stop.load(std::memory_order_relaxed);
+    }
+
+    // Splits the limits into a soft budget (do not start another iteration after it)
+    // and a hard budget (abort the running iteration). Both in milliseconds.
+    void compute_time_budget(const SearchLimits& limits, long long& soft_ms, long long& hard_ms) {
+        const long long MIN_BUDGET_MS = 10;
+        const long long CLOCK_SAFETY_MARGIN_MS = 50; // Kept back for unwinding, GUI and timer overhead
+        if (limits.movetime_ms > 0) {
+            soft_ms = std::max(limits.movetime_ms, MIN_BUDGET_MS);
+            hard_ms = soft_ms;
+        } else {
+            // Plan for ~25 more moves, spend most of the increment, never more than a quarter of the clock.
+            // The increment is only credited after the move, so the budget can never exceed what is left.
+            long long time_left = std::max(0LL, limits.time_left_ms);
+            long long usable_ms = std::max(0LL, time_left - CLOCK_SAFETY_MARGIN_MS);
+            soft_ms = time_left / 25 + limits.increment_ms * 3 / 4;
+            hard_ms = std::min({soft_ms * 3, time_left / 4 + limits.increment_ms, usable_ms});
+            soft_ms = std::min(soft_ms, hard_ms);
+            long long min_budget_ms = std::min(MIN_BUDGET_MS, time_left); // A floor must not overdraw the clock either
+            soft_ms = std::max(soft_ms, min_budget_ms);
+            hard_ms = std::max(hard_ms, min_budget_ms);
+        }
+    }
+
+    // Move ordering tables, one per search thread id. They outlive a single find_best_ai_move()
+    // call so killers, history and countermoves carry over to the next AI move.
+    std::vector<std::unique_ptr<MoveOrdering>> thread_move_ordering;
+
+    double elapsed_ms_since(SearchClock::time_point start) {
+        return std::chrono::duration<double, std::milli>(SearchClock::now() - start).count();
+    }
+
+    // Counts a node and polls the clock every TIME_CHECK_INTERVAL_NODES nodes.
+    // Returns true once the search has to unwind.
+    inline bool count_node_and_check_stop(long long& nodes_searched_ref) {
+        nodes_searched_ref++;
+        if ((nodes_searched_ref & (TIME_CHECK_INTERVAL_NODES - 1)) == 0 &&
+            search_deadline_armed.load(std::memory_order_relaxed) && SearchClock::now() >= search_hard_deadline) {
+            search_stop.store(true, std::memory_order_relaxed); // Scores from here on are meaningless; callers discard them
+            return true;
+        }
+        return false;
+    }
+
+    // Bound outside every real score ([LOSS_SCORE, WIN_SCORE]) that can still be negated safely.
+    const int INFINITE_SCORE = WIN_SCORE + 1;
+
+    // --- Aspiration windows (root) ---
+    const int ASPIRATION_MIN_DEPTH = 4;       // Shallower iterations are cheap enough for a full window
+    const int ASPIRATION_WINDOW = 50;         // Initial half-width around the previous score
+    const int ASPIRATION_MAX_WINDOW = 10000;  // Beyond this half-width the failing side is opened fully
+
+    // --- Null-move pruning ---
+    const int NULL_MOVE_MIN_DEPTH = 3;           // Shallower nodes are cheap enough to search normally
+    const int NULL_MOVE_MIN_PIECES = 3;          // With this few pieces left passing may really be best
+    const int NULL_MOVE_VERIFICATION_DEPTH = 8;  // Null-move cutoffs at or above this depth are verified
+
+    // Depth reduction of the null-move search: 2 plies, 3 from depth 7 on, 4 from depth 13.
+    inline int null_move_reduction(int depth) {
+        return 2 + (depth - 1) / 6;
+    }
+
+    // --- Late move reductions / late move pruning ---
+    const int LMR_MIN_DEPTH = 3;              // Shallower nodes are left to late move pruning
+    const int LMR_MIN_MOVE_INDEX = 3;         // The first moves are never reduced, whatever their class
+    const int LMP_MAX_DEPTH = 3;              // Late move pruning only this close to the horizon
+
+    // Plies to reduce the move at 'move_index' (0-based) at 'depth':
+    // int(base + ln(depth) * ln(move_index + 1) / divisor), built by init_lmr_table().
+    int lmr_reductions[MAX_SEARCH_DEPTH + 1][MAX_MOVES];
+    double lmr_table_base = -1.0;             // Parameters the table was built with (none yet)
+    double lmr_table_divisor = -1.0;
+
+    void init_lmr_table(double base, double divisor) {
+        for (int depth = 0; depth <= MAX_SEARCH_DEPTH; ++depth) {
+            for (int move_index = 0; move_index < MAX_MOVES; ++move_index) {
+                int reduction = 0;
+                if (depth > 0 && move_index > 0) {
+                    reduction = static_cast<int>(base + std::log(static_cast<double>(depth)) *
+                                                 std::log(static_cast<double>(move_index + 1)) / divisor);
+                }
+                lmr_reductions[depth][move_index] = std::max(0, reduction);
+            }
+        }
+        lmr_table_base = base;
+        lmr_table_divisor = divisor;
+    }
+
+    // Quiet moves beyond this many are skipped at 'depth' <= LMP_MAX_DEPTH: 5, 8, 13.
+    inline int late_move_pruning_count(int depth) {
+        return 4 + depth * depth;
+    }
+
+    // Squares from which a piece of [Player] reaches the enemy den in at most two steps: the enemy
+    // traps and their neighbours. Quiet moves landing here are never reduced or pruned, and a move
+    // entering the zone from outside is extended (see alpha_beta_search).
+    U64 den_approach_squares[3];
+    // The zone plus every square one step outside it: pieces here can start a den run.
+    U64 den_run_squares[3];
+
+    void init_den_approach_squares() {
+        den_approach_squares[NO_PLAYER] = 0ULL;
+        den_run_squares[NO_PLAYER] = 0ULL;
+        for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+            U64 enemy_traps = (p == PLAYER_1) ? TRAPS_NEAR_P2_DEN_MASK : TRAPS_NEAR_P1_DEN_MASK;
+            U64 enemy_den = (p == PLAYER_1) ? P2_DEN_SQUARE_MASK : P1_DEN_SQUARE_MASK;
+            U64 squares = enemy_traps;
+            U64 temp_traps = enemy_traps;
+            while (temp_traps) {
+                int trap_sq = pop_lsb(temp_traps);
+                squares |= AttackTables::RAT_STEP_TARGETS[trap_sq]; // Land steps plus the lake squares
+            }
+            den_approach_squares[p] = squares & ~enemy_den;
+
+            U64 run_squares = den_approach_squares[p];
+            U64 temp_zone = den_approach_squares[p];
+            while (temp_zone) {
+                run_squares |= AttackTables::RAT_STEP_TARGETS[pop_lsb(temp_zone)];
+            }
+            den_run_squares[p] = run_squares & ~enemy_den;
+        }
+    }
+
+    // --- Futility pruning / razoring (non-PV nodes at depth 1-2, no den threat) ---
+    // Futility: with the static eval this far below alpha, a quiet move cannot bring the score
+    // back. At the frontier (depth 1) it can only gain a PST step, well under half the cheapest
+    // piece; at the pre-frontier (depth 2) the quiescence search after the reply may also win a
+    // piece, which the opponent will not offer lightly, so the margin allows for a mid-sized one.
+    const int FUTILITY_MARGINS[3] = { 0, PIECE_VALUES[CAT] / 2, PIECE_VALUES[WOLF] };
+    // Razoring: with the static eval this far below alpha, the node is handed to the quiescence
+    // search right away (depth 1), or once that confirms the deficit (depth 2).
+    const int RAZOR_MARGINS[3] = { 0, PIECE_VALUES[CAT], PIECE_VALUES[PANTHER] };
+    const int FRONTIER_PRUNING_MAX_DEPTH = 2;
+
+    // --- Threat extensions ---
+    // Extensions one path may collect below the root: half the iteration depth (at least one),
+    // so no line grows much beyond 1.5 times the nominal depth.
+    inline int root_extension_budget(int depth) {
+        return std::max(1, depth / 2);
+    }
+
+    // --- Quiescence search settings ---
+    const int MAX_QUIESCENCE_PLY = 16;        // Safety cap on the length of a tactical sequence
+    const int QUIESCENCE_DELTA_MARGIN = 500;  // Largest PST gain a capture can add on top of the victim's value
+
+    // True if an enemy piece stands on one of the traps around 'player's den. Every square next to
+    // a den is a trap, so that piece walks into the den next move unless it is captured first.
+    inline bool den_under_threat(const BoardState& board_state, Player player) {
+        return den_entry_threats(board_state, player) != 0ULL;
+    }
+
+    // Quiescence move order: den entries, then captures by most valuable victim / least valuable
+    // attacker, then trap moves.
+    inline int tactical_move_order_key(const Move& move, U64 enemy_den_mask) {
+        if (get_bit(enemy_den_mask, move.to_sq)) return 1000000;
+        if (move.piece_captured != NO_PIECE_TYPE) {
+            return PIECE_VALUES[move.piece_captured] * 16 - PIECE_RANKS[move.piece_moved];
+        }
+        return 0;
+    }
+}
+
+
+int quiescence_search(
+    BoardState& board_state,
+    int alpha,
+    int beta,
+    int qs_ply,
+    long long& nodes_searched_ref,
+    RepetitionStack& repetition_stack
+) {
+    if (search_stopped()) return 0;
+    if (count_node_and_check_stop(nodes_searched_ref)) return 0;
+
+    Player us = board_state.side_to_move;
+    Player them = (us == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    int stand_pat = evaluate_board(board_state, us);
+    if (stand_pat == WIN_SCORE || stand_pat == LOSS_SCORE || qs_ply >= MAX_QUIESCENCE_PLY) {
+        return stand_pat;
+    }
+
+    // Stand pat: the side to move may decline every tactical move and keep the static eval.
+    // Not when an enemy piece sits on a trap next to our den: it enters the den next move,
+    // so unless a tactical move (capturing it, or entering the enemy den first) saves us, we lose.
+    bool must_respond = den_under_threat(board_state, us);
+    int best_score = LOSS_SCORE;
+    if (!must_respond) {
+        if (stand_pat >= beta) return stand_pat;
+        alpha = std::max(alpha, stand_pat);
+        best_score = stand_pat;
+    }
+
+    // Trap moves only on the first quiescence ply: they threaten den entry and are answered by
+    // the capture (or loss) one ply later, but chains of them would not converge.
+    MoveList tactical_moves;
+    generate_tactical_moves(board_state, us, qs_ply == 0, tactical_moves);
+
+    U64 enemy_den_mask = (us == PLAYER_1) ? P2_DEN_SQUARE_MASK : P1_DEN_SQUARE_MASK;
+    std::sort(tactical_moves.begin(), tactical_moves.end(), [&](const Move& a, const Move& b) {
+        return tactical_move_order_key(a, enemy_den_mask) > tactical_move_order_key(b, enemy_den_mask);
+    });
+
+    for (const Move& move : tactical_moves) {
+        bool is_capture = (move.piece_captured != NO_PIECE_TYPE);
+        bool is_den_entry = get_bit(enemy_den_mask, move.to_sq);
+
+        // Delta pruning: even winning the victim outright (plus the best PST swing) leaves us
+        // below alpha, so the capture cannot matter.
+        if (is_capture && !is_den_entry && !must_respond &&
+            stand_pat + PIECE_SQUARE_VALUES[move.piece_captured][them][move.to_sq] + QUIESCENCE_DELTA_MARGIN <= alpha) {
+            continue;
+        }
+
+        UndoInfo undo;
+        board_state.make_move(move, undo);
+        // A trap move is quiet and could be the third occurrence of a position (illegal).
+        // Captures and den entries always lead to a new position.
+        if (!is_capture && !is_den_entry && repetition_stack.count(board_state.zobrist_hash) >= 2) {
+            board_state.unmake_move(move, undo);
+            continue;
+        }
+        repetition_stack.push(board_state.zobrist_hash, is_capture);
+        int score = -quiescence_search(board_state, -beta, -alpha, qs_ply + 1, nodes_searched_ref, repetition_stack);
+        repetition_stack.pop();
+        board_state.unmake_move(move, undo);
+        if (search_stopped()) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
+        }
+    }
+    return best_score;
 }
 
 
 int alpha_beta_search(
-    BoardState board_state, 
+    BoardState& board_state, 
     int depth,
     int alpha,
     int beta,
-    Player player_for_whom_to_maximize, 
-    Player current_turn_in_state,
     long long& nodes_searched_ref,
-    const std::vector<BoardState>& game_history_for_this_node 
+    RepetitionStack& repetition_stack,
+    int ply,
+    const Move& previous_move,
+    MoveOrdering& move_ordering,
+    int extension_budget,
+    bool allow_null_move
 ) {
-    nodes_searched_ref++; 
+    if (search_stopped()) return 0;
+    if (depth <= 0) {
+        // Horizon: resolve pending captures and den threats instead of trusting the static eval.
+        return quiescence_search(board_state, alpha, beta, 0, nodes_searched_ref, repetition_stack);
+    }
+    if (count_node_and_check_stop(nodes_searched_ref)) return 0;
     U64 current_hash = board_state.zobrist_hash; 
-    int original_alpha_for_node_entry = alpha; // Store for TT flag determination
+    Player us = board_state.side_to_move;
+    int original_alpha = alpha; // For the TT flag
+
+    // --- Den Threat Extension ---
+    // An enemy piece next to our den enters it next move unless we capture it. If every such piece
+    // can be captured, the outcome hinges on the exchange that follows: search it one ply deeper,
+    // as long as this path has extensions left. (If one cannot be captured the node is lost unless
+    // we enter the enemy den first, which even a 1-ply search sees.)
+    U64 den_threats = den_entry_threats(board_state, us);
+    bool den_threatened = (den_threats != 0ULL);
+    if (den_threatened && extension_budget > 0 &&
+        (den_threats & ~attacked_trap_occupants(board_state, us)) == 0ULL) {
+        depth++;
+        extension_budget--;
+    }
 
     // --- Transposition Table Probe ---
-    TranspositionTable::TTEntry* tt_entry = TranspositionTable::probe_tt(current_hash);
-    if (tt_entry != nullptr && tt_entry->depth >= depth) {
-        // Entry is valid (key matched in probe_tt) and from a search at least as deep
-        if (tt_entry->flag == TranspositionTable::EntryFlag::EXACT_SCORE) {
-            return tt_entry->score;
-        }
-        if (tt_entry->flag == TranspositionTable::EntryFlag::LOWER_BOUND) {
-            alpha = std::max(alpha, tt_entry->score);
-        } else if (tt_entry->flag == TranspositionTable::EntryFlag::UPPER_BOUND) {
-            beta = std::min(beta, tt_entry->score);
-        }
-        if (alpha >= beta) {
-            return tt_entry->score; // This bound caused a cutoff
+    TranspositionTable::TTEntry tt_entry;
+    bool tt_hit = TranspositionTable::probe_tt(current_hash, tt_entry);
+    if (tt_hit && tt_entry.depth >= depth) {
+        // Entry is valid (key matched in probe_tt) and from a search at least as deep:
+        // return when its score or bound already decides this window.
+        if (tt_entry.flag == TranspositionTable::EntryFlag::EXACT_SCORE ||
+            (tt_entry.flag == TranspositionTable::EntryFlag::LOWER_BOUND && tt_entry.score >= beta) ||
+            (tt_entry.flag == TranspositionTable::EntryFlag::UPPER_BOUND && tt_entry.score <= alpha)) {
+            return tt_entry.score;
         }
     }
     // --- End TT Probe ---
 
-    int current_eval_score = evaluate_board(board_state, player_for_whom_to_maximize);
-    if (depth == 0 || current_eval_score == WIN_SCORE || current_eval_score == LOSS_SCORE) {
-        // Store leaf node or terminal state evaluation. Best move is irrelevant here.
+    int current_eval_score = evaluate_board(board_state, us);
+    if (current_eval_score == WIN_SCORE || current_eval_score == LOSS_SCORE) {
+        // Store terminal state evaluation. Best move is irrelevant here.
         TranspositionTable::store_tt_entry(current_hash, current_eval_score, depth, TranspositionTable::EntryFlag::EXACT_SCORE, Move());
         return current_eval_score;
     }
 
-    std::vector<Move> legal_moves = generate_all_legal_moves(board_state, current_turn_in_state, game_history_for_this_node);
+    bool pv_node = (beta - alpha > 1);
 
-    if (legal_moves.empty()) { 
-        int score = (current_turn_in_state == player_for_whom_to_maximize) ? LOSS_SCORE : WIN_SCORE;
-        TranspositionTable::store_tt_entry(current_hash, score, depth, TranspositionTable::EntryFlag::EXACT_SCORE, Move());
-        return score;  
+    // --- Razoring ---
+    // Far below alpha near the horizon, only a capture or a den entry could still matter, and
+    // the quiescence search looks at exactly those without generating every legal move.
+    // Not with a decisive bound (only a den run could reach it) and not while one of our pieces
+    // could start a den run: the quiet steps of a run are not quiescence moves.
+    bool frontier_node = search_use_futility_pruning && !pv_node && !den_threatened &&
+                         depth <= FRONTIER_PRUNING_MAX_DEPTH && alpha < WIN_SCORE / 2 && alpha > LOSS_SCORE / 2;
+    if (frontier_node && (board_state.occupancy_bbs[us] & den_run_squares[us]) == 0ULL &&
+        current_eval_score + RAZOR_MARGINS[depth] <= alpha) {
+        if (depth == 1) {
+            pruning_counters.razor_prunes++;
+            return quiescence_search(board_state, alpha, beta, 0, nodes_searched_ref, repetition_stack);
+        }
+        int razor_alpha = alpha - RAZOR_MARGINS[depth];
+        int razor_score = quiescence_search(board_state, razor_alpha, razor_alpha + 1, 0,
+                                            nodes_searched_ref, repetition_stack);
+        if (search_stopped()) return 0;
+        if (razor_score <= razor_alpha) {
+            pruning_counters.razor_prunes++;
+            return razor_score;
+        }
     }
 
-    // --- Move Ordering: Use TT's best move first if available from a previous (shallower) search ---
-    if (tt_entry != nullptr && tt_entry->best_move.from_sq != -1) {
-        auto it = std::find(legal_moves.begin(), legal_moves.end(), tt_entry->best_move);
-        if (it != legal_moves.end()) {
-            // Move the TT best move to the front of the list
-            std::rotate(legal_moves.begin(), it, it + 1);
+    // --- Null-Move Pruning ---
+    // With the static eval already >= beta, the side to move passes; if the opponent's reply,
+    // searched at reduced depth, still fails high, the node is cut. Not at PV nodes, not right
+    // after a null move (previous_move is null there), not while our den is threatened (passing
+    // simply loses) and not with very few pieces left.
+    if (search_use_null_move && allow_null_move && !pv_node && depth >= NULL_MOVE_MIN_DEPTH &&
+        previous_move.from_sq != -1 && current_eval_score >= beta &&
+        pop_count(board_state.occupancy_bbs[us]) > NULL_MOVE_MIN_PIECES && !den_threatened) {
+        int reduction = null_move_reduction(depth);
+        UndoInfo null_undo;
+        board_state.make_null_move(null_undo);
+        // Nothing after a pass can repeat a real position: mark it irreversible.
+        repetition_stack.push(board_state.zobrist_hash, true);
+        int null_score = -alpha_beta_search(board_state, depth - 1 - reduction, -beta, -beta + 1,
+                                            nodes_searched_ref, repetition_stack, ply + 1, Move(), move_ordering, extension_budget);
+        repetition_stack.pop();
+        board_state.unmake_null_move(null_undo);
+        if (search_stopped()) return 0;
+
+        if (null_score >= beta) {
+            if (null_score >= WIN_SCORE) null_score = beta; // A win found by passing is not proven
+            if (depth < NULL_MOVE_VERIFICATION_DEPTH) {
+                return null_score;
+            }
+            // Verification: a reduced search of this node with real moves (no null move here),
+            // against the rare zugzwang-like position where passing would be the best move.
+            int verified_score = alpha_beta_search(board_state, depth - reduction, beta - 1, beta,
+                                                   nodes_searched_ref, repetition_stack, ply, previous_move,
+                                                   move_ordering, extension_budget, false);
+            if (search_stopped()) return 0;
+            if (verified_score >= beta) {
+                return null_score;
+            }
         }
     }
-    // (Further move ordering like MVV-LVA for captures could be applied to the rest of legal_moves here)
 
+    MoveList legal_moves;
+    generate_all_legal_moves(board_state, us, repetition_stack, legal_moves);
+
+    if (legal_moves.empty()) { // The side to move is stuck and loses
+        TranspositionTable::store_tt_entry(current_hash, LOSS_SCORE, depth, TranspositionTable::EntryFlag::EXACT_SCORE, Move());
+        return LOSS_SCORE;  
+    }
+
+    // --- Move Ordering: TT move, den entries, captures (MVV/LVA), killers, countermove, history ---
+    Move tt_move = tt_hit ? tt_entry.best_move : Move();
+    U64 enemy_den_mask = (us == PLAYER_1) ? P2_DEN_SQUARE_MASK : P1_DEN_SQUARE_MASK;
+    std::array<int, MAX_MOVES> move_scores;
+    move_ordering.score_moves(legal_moves, tt_move, previous_move, us, ply, enemy_den_mask, move_scores);
+
+    // --- Principal Variation Search ---
+    // The first (best-ordered) move gets the full window. Every later move is only asked whether
+    // it beats alpha, with a zero window; the rare one that does is searched again with the full window.
+    // Late quiet moves are asked at reduced depth first (LMR, from the ln(depth) * ln(index) table),
+    // or skipped near the horizon outside the PV (LMP).
+    int best_score = -INFINITE_SCORE;
     Move best_move_found_at_this_node; 
+    // With an enemy piece on one of our traps every move is a possible defence: search them all fully.
+    bool late_moves_allowed = search_use_late_move_reductions && !den_threatened;
+    // Futility pruning: quiet moves here cannot lift the score above futility_score (<= alpha).
+    int futility_score = frontier_node ? current_eval_score + FUTILITY_MARGINS[depth] : 0;
+    bool futility_pruning = frontier_node && futility_score <= alpha;
+    U64 searched_moves = 0ULL; // Bit i set once legal_moves[i] has been searched (not pruned)
+
+    for (int move_index = 0; move_index < legal_moves.size(); ++move_index) {
+        pick_next_move(legal_moves, move_scores, move_index);
+        const Move& move = legal_moves[move_index];
+
+        // Futility pruning: any quiet move except the ones approaching the enemy den. The skipped
+        // moves count as failing low at futility_score, so the node never returns a false loss.
+        if (futility_pruning && move.piece_captured == NO_PIECE_TYPE &&
+            !get_bit(enemy_den_mask | den_approach_squares[us], move.to_sq)) {
+            pruning_counters.futility_prunes++;
+            best_score = std::max(best_score, futility_score);
+            continue;
+        }
+
+        // Quiet moves ordered by history alone (no TT move, den entry, capture, killer or
+        // countermove) that do not approach the enemy den: candidates for reduction and pruning.
+        bool late_quiet = late_moves_allowed && move_scores[move_index] < MoveOrdering::COUNTERMOVE_SCORE &&
+                          !get_bit(den_approach_squares[us], move.to_sq);
+
+        // Late move pruning: near the horizon such moves almost never matter once enough others have
+        // been tried. Only after a move that does not lose, so the node never returns a false loss.
+        if (late_quiet && !pv_node && depth <= LMP_MAX_DEPTH && move_index >= late_move_pruning_count(depth) &&
+            best_score > LOSS_SCORE) {
+            continue;
+        }
+
+        // Den run extension: a piece stepping into the den approach zone is two moves from the enemy
+        // den. Whether the run can still be stopped is decided just beyond where it starts, so
+        // such a move is searched one ply deeper (the path pays for it from its budget).
+        int extension = (extension_budget > 0 && get_bit(den_approach_squares[us], move.to_sq) &&
+                         !get_bit(den_approach_squares[us], move.from_sq)) ? 1 : 0;
+        int child_depth = depth - 1 + extension;
+        int child_budget = extension_budget - extension;
+        searched_moves |= 1ULL << move_index;
+
+        UndoInfo undo;
+        board_state.make_move(move, undo);
+        TranspositionTable::prefetch_tt(board_state.zobrist_hash);
+        repetition_stack.push(board_state.zobrist_hash, move.piece_captured != NO_PIECE_TYPE);
+
+        int score;
+        if (move_index == 0) {
+            score = -alpha_beta_search(board_state, child_depth, -beta, -alpha,
+                                       nodes_searched_ref, repetition_stack, ply + 1, move, move_ordering, child_budget);
+        } else {
+            // Late move reduction: a zero-window search at reduced depth first; only a move that
+            // beats alpha there is searched again to full depth.
+            int reduction = 0;
+            if (late_quiet && depth >= LMR_MIN_DEPTH && move_index >= LMR_MIN_MOVE_INDEX) {
+                reduction = lmr_reductions[std::min(depth, MAX_SEARCH_DEPTH)][move_index];
+                if (pv_node) reduction--;
+                reduction = std::max(0, std::min(reduction, depth - 2)); // Keep at least one ply
+            }
+            score = -alpha_beta_search(board_state, child_depth - reduction, -alpha - 1, -alpha,
+                                       nodes_searched_ref, repetition_stack, ply + 1, move, move_ordering, child_budget);
+            if (reduction > 0 && score > alpha) {
+                score = -alpha_beta_search(board_state, child_depth, -alpha - 1, -alpha,
+                                           nodes_searched_ref, repetition_stack, ply + 1, move, move_ordering, child_budget);
+            }
+            if (score > alpha && score < beta) {
+                score = -alpha_beta_search(board_state, child_depth, -beta, -alpha,
+                                           nodes_searched_ref, repetition_stack, ply + 1, move, move_ordering, child_budget);
+            }
+        }
+
+        repetition_stack.pop();
+        board_state.unmake_move(move, undo);
+        if (search_stopped()) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            best_move_found_at_this_node = move;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) { // Beta cutoff (fail high)
+                    move_ordering.update_on_cutoff(legal_moves, move_index, searched_moves, previous_move, us, ply, depth);
+                    break;
+                }
+            }
+        }
+    }
+
     TranspositionTable::EntryFlag flag_for_tt_store;
+    if (best_score >= beta) {
+        flag_for_tt_store = TranspositionTable::EntryFlag::LOWER_BOUND;
+    } else if (best_score > original_alpha) {
+        flag_for_tt_store = TranspositionTable::EntryFlag::EXACT_SCORE;
+    } else {
+        flag_for_tt_store = TranspositionTable::EntryFlag::UPPER_BOUND; // No move raised alpha
+    }
+    TranspositionTable::store_tt_entry(current_hash, best_score, depth, flag_for_tt_store, best_move_found_at_this_node);
+    return best_score;
+}
+
 
-    if (current_turn_in_state == player_for_whom_to_maximize) { 
-        int max_eval = std::numeric_limits<int>::min(); 
-        flag_for_tt_store = TranspositionTable::EntryFlag::UPPER_BOUND; // Assume all moves fail low initially
+namespace {
+    // Per-thread search state for Lazy SMP. Every thread searches the same root position on its
+    // own board and repetition stack; they cooperate only through the shared transposition table.
+    struct SearchThread {
+        int id;                                // 0 = main thread (owns the result and the time management)
+        BoardState board;
+        RepetitionStack repetition_stack;
+        std::array<std::pair<int, Move>, MAX_MOVES> root_moves;
+        int root_moves_count;
+        long long nodes;
+        MoveOrdering* move_ordering;           // This thread's slot in thread_move_ordering
+        long long futility_prunes;             // This thread's PruningCounters, once its search is over
+        long long razor_prunes;
 
-        for (const Move& move : legal_moves) {
-            std::vector<BoardState> next_history = game_history_for_this_node;
-            next_history.push_back(board_state); 
+        SearchThread() : id(0), root_moves_count(0), nodes(0), move_ordering(nullptr),
+                         futility_prunes(0), razor_prunes(0) {}
+    };
+
+
+    // Searches the root moves to 'depth' within the window (alpha, beta), in the thread's root move
+    // order, principal variation style: the first move with the full window, the others with a zero
+    // window and a full re-search only if they beat alpha. Stops at the first fail high (score >= beta).
+    // Returns the number of root moves searched to completion; 'best_move'/'best_score' describe the
+    // best of those (best_score <= alpha: every move failed low, >= beta: a move failed high).
+    int search_root_moves(SearchThread& thread, int depth, int alpha, int beta, long long& nodes_searched_ref,
+                          Move& best_move, int& best_score) {
+        int completed = 0;
+        best_score = -INFINITE_SCORE;
+        int extension_budget = root_extension_budget(depth);
+
+        for (int i = 0; i < thread.root_moves_count; ++i) { 
+            const Move& move = thread.root_moves[i].second; 
+
+            UndoInfo undo;
+            thread.board.make_move(move, undo);
+            TranspositionTable::prefetch_tt(thread.board.zobrist_hash);
+            thread.repetition_stack.push(thread.board.zobrist_hash, move.piece_captured != NO_PIECE_TYPE);
+            int score_for_this_move;
+            if (i == 0) {
+                score_for_this_move = -alpha_beta_search(thread.board, depth - 1, -beta, -alpha, nodes_searched_ref,
+                                                         thread.repetition_stack, 1, move, *thread.move_ordering, extension_budget);
+            } else {
+                score_for_this_move = -alpha_beta_search(thread.board, depth - 1, -alpha - 1, -alpha, nodes_searched_ref,
+                                                         thread.repetition_stack, 1, move, *thread.move_ordering, extension_budget);
+                if (score_for_this_move > alpha && score_for_this_move < beta) {
+                    score_for_this_move = -alpha_beta_search(thread.board, depth - 1, -beta, -alpha, nodes_searched_ref,
+                                                             thread.repetition_stack, 1, move, *thread.move_ordering, extension_budget);
+                }
+            }
+            thread.repetition_stack.pop();
+            thread.board.unmake_move(move, undo);
+            if (search_stopped()) break;
 
-            BoardState next_state = make_move_on_copy(board_state, move);
-            int eval = alpha_beta_search(next_state, depth - 1, alpha, beta, player_for_whom_to_maximize, next_state.side_to_move, nodes_searched_ref, next_history);
-            
-            if (eval > max_eval) {
-                max_eval = eval;
-                best_move_found_at_this_node = move;
+            completed++;
+            if (score_for_this_move > best_score) {
+                best_score = score_for_this_move;
+                best_move = move;
             }
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) { // Beta cutoff (fail high)
-                flag_for_tt_store = TranspositionTable::EntryFlag::LOWER_BOUND;
-                break; 
+            if (score_for_this_move > alpha) {
+                alpha = score_for_this_move;
+                if (alpha >= beta) break; // Fail high: the caller widens the aspiration window
             }
         }
-        // Refined flag determination
-        if (max_eval > original_alpha_for_node_entry && max_eval < beta) { // Check against original beta passed to this node
-             flag_for_tt_store = TranspositionTable::EntryFlag::EXACT_SCORE;
-        } // else it remains UPPER_BOUND (if no move raised alpha) or becomes LOWER_BOUND (if beta cutoff)
-        
-        TranspositionTable::store_tt_entry(current_hash, max_eval, depth, flag_for_tt_store, best_move_found_at_this_node);
-        return max_eval;
-    } else { // Minimizing player's turn
-        int min_eval = std::numeric_limits<int>::max(); 
-        flag_for_tt_store = TranspositionTable::EntryFlag::LOWER_BOUND; // Assume all moves fail high initially
-
-        for (const Move& move : legal_moves) {
-            std::vector<BoardState> next_history = game_history_for_this_node;
-            next_history.push_back(board_state);
-
-            BoardState next_state = make_move_on_copy(board_state, move);
-            int eval = alpha_beta_search(next_state, depth - 1, alpha, beta, player_for_whom_to_maximize, next_state.side_to_move, nodes_searched_ref, next_history);
-            
-            if (eval < min_eval) {
-                min_eval = eval;
-                best_move_found_at_this_node = move;
+        return completed;
+    }
+
+
+    // Moves 'move' to the front of the thread's root moves, keeping the order of the others.
+    void move_root_move_to_front(SearchThread& thread, const Move& move) {
+        for (int i = 0; i < thread.root_moves_count; ++i) {
+            if (thread.root_moves[i].second == move) {
+                std::rotate(thread.root_moves.begin(), thread.root_moves.begin() + i, thread.root_moves.begin() + i + 1);
+                break;
             }
-            beta = std::min(beta, eval);
-            if (beta <= alpha) { // Alpha cutoff (fail low)
-                flag_for_tt_store = TranspositionTable::EntryFlag::UPPER_BOUND;
-                break; 
+        }
+    }
+
+
+    // Iterative deepening on one thread. The main thread fills 'result' and decides when to stop;
+    // helper threads (result == nullptr) only fill the shared TT and run until search_stop is set.
+    // Helpers are desynchronised from the main thread so they do not all search the same tree:
+    // odd helpers skip every other depth, and each helper shuffles the root moves after the first.
+    // From ASPIRATION_MIN_DEPTH on, each iteration starts with a narrow window around the previous
+    // iteration's score and widens it on the side that failed until the score lands inside.
+    void iterative_deepening(SearchThread& thread, const SearchLimits& limits,
+                             SearchClock::time_point time_start, long long soft_budget_ms,
+                             AiMoveResult* result) {
+        bool is_main = (result != nullptr);
+        bool time_limited = limits.is_time_limited();
+        int max_depth = std::max(1, std::min(limits.max_depth, MAX_SEARCH_DEPTH));
+        int first_depth = 1;
+        int depth_step = 1;
+        bool have_previous_score = false;
+        int previous_score = 0;
+        pruning_counters = PruningCounters{0, 0}; // The main thread's would still hold its previous search
+
+        if (!is_main) {
+            if (thread.id % 2 == 1) {
+                first_depth = 2;
+                depth_step = 2;
+            }
+            if (thread.root_moves_count > 2) {
+                std::mt19937 rng(static_cast<unsigned>(thread.id));
+                std::shuffle(thread.root_moves.begin() + 1, thread.root_moves.begin() + thread.root_moves_count, rng);
             }
         }
-        // Refined flag determination
-        if (min_eval < beta && min_eval > alpha) { // Check against original alpha passed to this node
-            flag_for_tt_store = TranspositionTable::EntryFlag::EXACT_SCORE;
-        } // else it remains LOWER_BOUND (if no move lowered beta below original beta) or becomes UPPER_BOUND (if alpha cutoff)
 
-        TranspositionTable::store_tt_entry(current_hash, min_eval, depth, flag_for_tt_store, best_move_found_at_this_node);
-        return min_eval;
+        for (int depth = std::min(first_depth, max_depth); depth <= max_depth; depth += depth_step) {
+            auto iteration_start = SearchClock::now();
+            long long iteration_nodes = 0;
+            Move iteration_best_move;
+            int iteration_best_score = -INFINITE_SCORE;
+
+            // --- Aspiration window ---
+            int alpha = -INFINITE_SCORE;
+            int beta = INFINITE_SCORE;
+            int delta = ASPIRATION_WINDOW;
+            if (depth >= ASPIRATION_MIN_DEPTH && have_previous_score &&
+                previous_score != WIN_SCORE && previous_score != LOSS_SCORE) {
+                alpha = std::max(previous_score - delta, -INFINITE_SCORE);
+                beta = std::min(previous_score + delta, INFINITE_SCORE);
+            }
+
+            int completed_moves = 0;
+            while (true) {
+                completed_moves = search_root_moves(thread, depth, alpha, beta, iteration_nodes,
+                                                    iteration_best_move, iteration_best_score);
+                if (search_stopped()) break;
+
+                bool failed_low = (iteration_best_score <= alpha);
+                bool failed_high = (iteration_best_score >= beta);
+                if (!failed_low && !failed_high) break;
+
+                // Widen the failing side; once the step gets large (or the score is decisive) open it fully.
+                delta *= 4;
+                bool open_fully = delta > ASPIRATION_MAX_WINDOW ||
+                                  iteration_best_score == WIN_SCORE || iteration_best_score == LOSS_SCORE;
+                if (failed_low) {
+                    alpha = open_fully ? -INFINITE_SCORE : std::max(iteration_best_score - delta, -INFINITE_SCORE);
+                } else {
+                    beta = open_fully ? INFINITE_SCORE : std::min(iteration_best_score + delta, INFINITE_SCORE);
+                    move_root_move_to_front(thread, iteration_best_move); // The re-search starts with the move that failed high
+                }
+            }
+            thread.nodes += iteration_nodes;
+
+            if (search_stopped()) {
+                // Stopped by the clock (main) or by the main thread finishing (helpers).
+                // The first move is the previous best (or the move that failed high), so once a move
+                // scored inside the window it is either that move confirmed or a genuine improvement
+                // found at the deeper depth.
+                // A fail-low result is only an upper bound and is not used.
+                if (is_main && completed_moves > 0 && iteration_best_move.from_sq != -1 && iteration_best_score > alpha) {
+                    result->best_move = iteration_best_move;
+                    result->final_score = iteration_best_score;
+                }
+                break;
+            }
+
+            // The final window contained the score, so the root score is exact.
+            TranspositionTable::store_tt_entry(thread.board.zobrist_hash, iteration_best_score, depth,
+                                               TranspositionTable::EntryFlag::EXACT_SCORE, iteration_best_move);
+            have_previous_score = true;
+            previous_score = iteration_best_score;
+
+            // Search this iteration's best move (the root TT move) first in the next iteration.
+            move_root_move_to_front(thread, iteration_best_move);
+
+            if (is_main) {
+                result->best_move = iteration_best_move;
+                result->final_score = iteration_best_score;
+                result->depth_reached = depth;
+
+                IterationInfo info;
+                info.depth = depth;
+                info.score = iteration_best_score;
+                info.best_move = iteration_best_move;
+                info.nodes = iteration_nodes;
+                info.time_ms = elapsed_ms_since(iteration_start);
+                result->iterations.push_back(info);
+
+                // Depth 1 always runs to completion, so there is a real move even with a tiny budget.
+                if (time_limited) {
+                    search_deadline_armed.store(true, std::memory_order_relaxed);
+                }
+                if (iteration_best_score == WIN_SCORE || iteration_best_score == LOSS_SCORE) {
+                    break; // Decided: deeper iterations cannot change the outcome
+                }
+                if (time_limited && elapsed_ms_since(time_start) >= static_cast<double>(soft_budget_ms)) {
+                    break; // Out of the soft budget: not worth starting an iteration that cannot finish
+                }
+            }
+        }
+
+        thread.futility_prunes = pruning_counters.futility_prunes;
+        thread.razor_prunes = pruning_counters.razor_prunes;
+        TranspositionTable::flush_thread_stats();
     }
 }
 
 
 AiMoveResult find_best_ai_move(
     const BoardState& current_board_state, 
-    int search_depth,
-    const std::vector<BoardState>& game_history_ref 
+    const SearchLimits& limits,
+    const RepetitionStack& game_repetition_stack
 ) {
     AiMoveResult result; 
     Player ai_player = PLAYER_1; 
 
-    std::vector<Move> legal_moves_generated = generate_all_legal_moves(current_board_state, ai_player, game_history_ref);
-    result.root_moves_count = static_cast<int>(legal_moves_generated.size());
+    MoveList legal_moves_generated;
+    generate_all_legal_moves(current_board_state, ai_player, game_repetition_stack, legal_moves_generated);
+    result.root_moves_count = legal_moves_generated.size();
 
     if (legal_moves_generated.empty()) {
         return result; 
     }
 
+    auto time_start = SearchClock::now();
+    long long soft_budget_ms = 0;
+    long long hard_budget_ms = 0;
+    search_stop.store(false);
+    search_deadline_armed.store(false);
+    search_use_null_move = limits.use_null_move;
+    search_use_late_move_reductions = limits.use_late_move_reductions;
+    search_use_futility_pruning = limits.use_futility_pruning;
+    if (limits.lmr_base != lmr_table_base || limits.lmr_divisor != lmr_table_divisor) {
+        init_lmr_table(limits.lmr_base, limits.lmr_divisor);
+    }
+    if (den_approach_squares[PLAYER_1] == 0ULL) {
+        init_den_approach_squares(); // Needs init_masks(), which has run long before any search
+    }
+    TranspositionTable::new_search(); // Age out entries from earlier moves before any thread stores
+    if (limits.is_time_limited()) {
+        compute_time_budget(limits, soft_budget_ms, hard_budget_ms);
+        search_hard_deadline = time_start + std::chrono::milliseconds(hard_budget_ms);
+    }
+
+    // The main thread's state. The whole search runs on this one working board and repetition
+    // stack; every node makes and unmakes its moves (and pushes/pops its key) on them.
+    int num_threads = std::max(1, std::min(limits.num_threads, MAX_SEARCH_THREADS));
+    while (static_cast<int>(thread_move_ordering.size()) < num_threads) {
+        thread_move_ordering.emplace_back(new MoveOrdering());
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        thread_move_ordering[i]->new_search();
+    }
+
+    SearchThread main_thread;
+    main_thread.id = 0;
+    main_thread.move_ordering = thread_move_ordering[0].get();
+    main_thread.board = current_board_state;
+    main_thread.repetition_stack = game_repetition_stack;
+
     // --- Move Ordering Step (Static Eval + TT Best Move) ---
-    std::vector<std::pair<int, Move>> scored_root_moves;
-    TranspositionTable::TTEntry* root_tt_entry = TranspositionTable::probe_tt(current_board_state.zobrist_hash);
+    TranspositionTable::TTEntry root_tt_entry;
+    bool root_tt_hit = TranspositionTable::probe_tt(current_board_state.zobrist_hash, root_tt_entry);
     Move tt_best_move_at_root; // Default invalid
-    if (root_tt_entry != nullptr && root_tt_entry->best_move.from_sq != -1) {
+    if (root_tt_hit && root_tt_entry.best_move.from_sq != -1) {
         // Check if the TT best move is actually in the list of legal moves for this turn
         // (it might be from a different search depth or a slightly different history context)
-        bool tt_move_is_legal = false;
         for(const auto& legal_move : legal_moves_generated) {
-            if (legal_move == root_tt_entry->best_move) {
-                tt_move_is_legal = true;
+            if (legal_move.same_squares(root_tt_entry.best_move)) {
+                tt_best_move_at_root = legal_move; // The full move, including any captured piece
                 break;
             }
         }
-        if (tt_move_is_legal) {
-            tt_best_move_at_root = root_tt_entry->best_move;
-        }
     }
 
     for (const Move& move : legal_moves_generated) {
-        BoardState temp_next_state = make_move_on_copy(current_board_state, move);
-        int static_eval = evaluate_board(temp_next_state, ai_player); 
+        UndoInfo undo;
+        main_thread.board.make_move(move, undo);
+        int static_eval = evaluate_board(main_thread.board, ai_player); 
+        main_thread.board.unmake_move(move, undo);
         if (move == tt_best_move_at_root) { // Check if this is the TT's preferred move
             static_eval += 1000000; // Large bonus to ensure it's sorted first
         }
-        scored_root_moves.push_back({static_eval, move});
+        main_thread.root_moves[main_thread.root_moves_count++] = {static_eval, move};
     }
-    std::sort(scored_root_moves.begin(), scored_root_moves.end(), [](const auto& a, const auto& b) {
+    std::sort(main_thread.root_moves.begin(), main_thread.root_moves.begin() + main_thread.root_moves_count, [](const auto& a, const auto& b) {
         return a.first > b.first; 
     });
     // --- End Move Ordering Step ---
 
-    auto time_start = std::chrono::high_resolution_clock::now();
-    long long total_nodes_for_search_at_root = 0; 
-
-    int alpha = std::numeric_limits<int>::min();
-    int beta = std::numeric_limits<int>::max();
-    bool first_move_evaluated = false;
-    // result.best_move is already default constructed to invalid
-
-    for (const auto& scored_move_pair : scored_root_moves) { 
-        const Move& move = scored_move_pair.second; 
-        BoardState next_state_after_ai_move = make_move_on_copy(current_board_state, move);
-        long long nodes_for_this_branch = 0; 
-        
-        std::vector<BoardState> history_for_branch = game_history_ref;
-        history_for_branch.push_back(current_board_state); 
-
-        int score_for_this_move = alpha_beta_search(
-            next_state_after_ai_move, 
-            search_depth - 1, 
-            alpha, 
-            beta, 
-            ai_player, 
-            next_state_after_ai_move.side_to_move, 
-            nodes_for_this_branch,
-            history_for_branch 
-        );
-        total_nodes_for_search_at_root += nodes_for_this_branch;
-        
-        if (!first_move_evaluated || score_for_this_move > result.final_score) {
-            result.final_score = score_for_this_move;
-            result.best_move = move;
-            first_move_evaluated = true;
-        }
-        alpha = std::max(alpha, result.final_score); 
-        // No beta cutoff at the root itself, as we want to find the true best move.
-        // Alpha is updated to narrow the window for subsequent sibling root moves.
-    }
-
-    auto time_end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::milli> time_diff_ms = time_end - time_start;
-    result.time_taken_ms = time_diff_ms.count();
-    result.nodes_searched = total_nodes_for_search_at_root; 
-
-    // Store the result of the root search in TT
-    if (result.best_move.from_sq != -1) {
-        TranspositionTable::EntryFlag root_flag;
-        // This flag determination at root is tricky. If alpha changed from initial -inf, it's at least that good.
-        // If result.final_score == alpha (after loop), it could be an exact score or a score that failed high.
-        // For simplicity, we often store root results as EXACT if a move was found.
-        // More accurately:
-        if (result.final_score <= alpha) { // Alpha was original alpha if no move improved it.
-             root_flag = TranspositionTable::EntryFlag::UPPER_BOUND; // All moves were bad
-        } else if (result.final_score >= beta ) { // Should not happen if beta is max_int at root
-             root_flag = TranspositionTable::EntryFlag::LOWER_BOUND;
-        }
-        else {
-             root_flag = TranspositionTable::EntryFlag::EXACT_SCORE;
-        }
-        TranspositionTable::store_tt_entry(current_board_state.zobrist_hash, result.final_score, search_depth, root_flag, result.best_move);
+    // --- Lazy SMP: helpers start from a copy of the main thread's state ---
+    std::vector<SearchThread> helper_threads(num_threads - 1, main_thread);
+    std::vector<std::thread> workers;
+    workers.reserve(helper_threads.size());
+    for (size_t i = 0; i < helper_threads.size(); ++i) {
+        helper_threads[i].id = static_cast<int>(i) + 1;
+        helper_threads[i].move_ordering = thread_move_ordering[i + 1].get();
+        workers.emplace_back(iterative_deepening, std::ref(helper_threads[i]), std::cref(limits),
+                             time_start, soft_budget_ms, nullptr);
     }
 
+    iterative_deepening(main_thread, limits, time_start, soft_budget_ms, &result);
+
+    search_stop.store(true); // Main thread decided: release the helpers
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    search_deadline_armed.store(false);
+
+    result.nodes_searched = main_thread.nodes;
+    result.futility_prunes = main_thread.futility_prunes;
+    result.razor_prunes = main_thread.razor_prunes;
+    for (const SearchThread& helper : helper_threads) {
+        result.nodes_searched += helper.nodes;
+        result.futility_prunes += helper.futility_prunes;
+        result.razor_prunes += helper.razor_prunes;
+    }
+    result.threads_used = num_threads;
+    for (int i = 0; i < num_threads; ++i) {
+        result.beta_cutoffs += thread_move_ordering[i]->cutoffs;
+        result.first_move_cutoffs += thread_move_ordering[i]->first_move_cutoffs;
+    }
+    result.time_taken_ms = elapsed_ms_since(time_start);
 
     if (result.best_move.from_sq == -1 && !legal_moves_generated.empty()) {
         result.best_move = legal_moves_generated[0]; 
         if (result.final_score == std::numeric_limits<int>::min()) { 
-             BoardState fallback_state = make_move_on_copy(current_board_state, result.best_move);
-             result.final_score = evaluate_board(fallback_state, ai_player); 
+             UndoInfo undo;
+             main_thread.board.make_move(result.best_move, undo); // Back at the root once the search is over
+             result.final_score = evaluate_board(main_thread.board, ai_player);
+             main_thread.board.unmake_move(result.best_move, undo);
         }
     }
     return result;
 }
 
-
+void clear_move_ordering() {
+    for (std::unique_ptr<MoveOrdering>& move_ordering : thread_move_ordering) {
+        move_ordering->clear();
+    }
+}
@@ -5,11 +5,59 @@
 #include "piece.h"       // For BoardState, Player, PieceType, etc.
 #include "movegen.h"     // For Move struct and generate_all_legal_moves
 #include "evaluation.h"  // For evaluate_board and WIN_SCORE/LOSS_SCORE
+#include "repetition.h"  // For RepetitionStack
+#include "move_ordering.h" // For MoveOrdering (killer, history and countermove tables)
 #include <vector>
 #include <limits>       // For std::numeric_limits
 
 // --- AI Configuration ---
 const int DEFAULT_AI_SEARCH_DEPTH = 6;  // recommended depths: for release-version: 6-7 , for debug-version: 5
+const int MAX_SEARCH_DEPTH = 64;        // Depth cap for time-controlled searches without an explicit --depth
+const int MAX_SEARCH_THREADS = 256;     // Upper bound for --threads
+const double DEFAULT_LMR_BASE = 0.75;   // Late move reduction table defaults, see SearchLimits (--lmr)
+const double DEFAULT_LMR_DIVISOR = 2.25;
+
+// Limits for one AI move search. Iterative deepening runs depth 1, 2, ... up to max_depth,
+// and stops earlier once the time budget derived from the other fields is used up.
+// A time field of 0 means "not set"; with no time fields set the search is depth-limited only.
+struct SearchLimits {
+    int max_depth;           // Deepest iteration to run (plies)
+    long long movetime_ms;   // Fixed thinking time per move
+    long long time_left_ms;  // Remaining game clock of the AI (increment-style time control)
+    long long increment_ms;  // Increment the AI receives after each move
+    int num_threads;         // Lazy SMP: total search threads sharing the TT (1 = single-threaded)
+    bool use_null_move;      // Null-move pruning on/off (for A/B testing its effect)
+    bool use_late_move_reductions; // Late move reductions and late move pruning on/off
+    double lmr_base;         // Reduction table: base + ln(depth) * ln(move number) / divisor plies
+    double lmr_divisor;
+    bool use_futility_pruning; // Futility pruning and razoring at depth 1-2 on/off
+
+    SearchLimits() : 
+        max_depth(DEFAULT_AI_SEARCH_DEPTH), 
+        movetime_ms(0), 
+        time_left_ms(0), 
+        increment_ms(0),
+        num_threads(1),
+        use_null_move(true),
+        use_late_move_reductions(true),
+        lmr_base(DEFAULT_LMR_BASE),
+        lmr_divisor(DEFAULT_LMR_DIVISOR),
+        use_futility_pruning(true)
+    {}
+
+    bool is_time_limited() const { return movetime_ms > 0 || time_left_ms > 0; }
+};
+
+// Result of one completed iterative-deepening iteration
+struct IterationInfo {
+    int depth;
+    int score;
+    Move best_move;
+    long long nodes;  // Nodes searched in this iteration
+    double time_ms;   // Time spent in this iteration
+
+    IterationInfo() : depth(0), score(0), nodes(0), time_ms(0.0) {}
+};
 
 // Struct to hold the results of the AI's move search
 struct AiMoveResult {
@@ -18,48 +66,92 @@ struct AiMoveResult {
     long long nodes_searched; 
     double time_taken_ms;   
     int root_moves_count;   
+    int depth_reached;                    // Deepest fully completed iteration (main thread)
+    std::vector<IterationInfo> iterations; // One entry per completed iteration (main thread)
+    int threads_used;                     // nodes_searched is summed over all of them
+    long long beta_cutoffs;               // Beta cutoffs at interior nodes, all threads
+    long long first_move_cutoffs;         // ... of which by the first move searched (ordering quality)
+    long long futility_prunes;            // Quiet moves skipped by futility pruning, all threads
+    long long razor_prunes;               // Nodes resolved by razoring (quiescence search), all threads
 
     AiMoveResult() : 
         final_score(std::numeric_limits<int>::min()), 
         nodes_searched(0), 
         time_taken_ms(0.0), 
-        root_moves_count(0) 
+        root_moves_count(0),
+        depth_reached(0),
+        threads_used(1),
+        beta_cutoffs(0),
+        first_move_cutoffs(0),
+        futility_prunes(0),
+        razor_prunes(0)
     {
         best_move = Move(); 
     }
 };
 
 
-// --- Helper Function ---
-// Applies a move to a given board state and returns the new state.
-BoardState make_move_on_copy(const BoardState& current_board_state, const Move& move);
+// --- Quiescence Search ---
+// Searches only tactical moves (captures, den entries and, on its first ply, moves onto the traps
+// next to the enemy den) below the horizon, so the static eval is taken in quiet positions.
+// Negamax form: the score is from the perspective of the side to move in 'board_state'.
+// Uses stand-pat cutoffs (except while an enemy piece threatens to enter our den) and delta pruning.
+// 'qs_ply' counts plies below the horizon (0 at the first one).
+int quiescence_search(
+    BoardState& board_state,
+    int alpha,
+    int beta,
+    int qs_ply,
+    long long& nodes_searched_ref,
+    RepetitionStack& repetition_stack
+);
 
 
 // --- Alpha-Beta Search Function ---
-// Returns the evaluation of the board from the perspective of 'player_for_whom_to_maximize'.
-// 'nodes_searched_ref' is passed by reference to accumulate the node count.
-// 'game_history_ref' provides the history of board states for repetition checking.
+// Negamax principal variation search (pruning, reductions and extensions are described in ai.cpp).
+// Returns the score of 'board_state' for its side to move: exact inside (alpha, beta), a bound outside.
+// Children are visited with make_move/unmake_move and pushed/popped on 'repetition_stack' (every
+// position so far, ending with 'board_state'), so both are back in their original state on return.
+// 'ply' is the distance from the root, 'previous_move' the move that led here (null after a pass),
+// 'move_ordering' the thread's ordering tables and 'extension_budget' the extensions this path may
+// still take. 'allow_null_move' = false forbids null-move pruning at this node. Nodes are added to
+// 'nodes_searched_ref'; at depth 0 the position goes to quiescence_search.
 int alpha_beta_search(
-    BoardState board_state, 
+    BoardState& board_state, 
     int depth,
     int alpha,
     int beta,
-    Player player_for_whom_to_maximize, 
-    Player current_turn_in_state,
     long long& nodes_searched_ref,
-    const std::vector<BoardState>& game_history_ref // <<<< ADDED for repetition checking
+    RepetitionStack& repetition_stack,
+    int ply,
+    const Move& previous_move,
+    MoveOrdering& move_ordering,
+    int extension_budget,
+    bool allow_null_move = true
 );
 
 
 // --- Root AI Move Selection Function ---
-// Finds the best move for the AI (PLAYER_1) and gathers search statistics.
-// 'game_history_ref' provides the history of board states for repetition checking.
+// Finds the best move for the AI (PLAYER_1) by iterative deepening within 'limits',
+// and gathers search statistics. Iterations from depth 4 on use an aspiration window around
+// the previous iteration's score, widened and re-searched when the score falls outside it.
+// With limits.num_threads > 1, helper threads search the same position in parallel (Lazy SMP)
+// and share their work through the transposition table; the reported move is the main thread's.
+// The best move of each iteration (also stored in the TT) is searched first in the next one;
+// interior nodes are ordered with per-thread killer, history and countermove tables that persist
+// across iterations and AI moves. If time runs out mid-iteration, the result of the last
+// completed iteration is used (or the partial one, if its first move was finished).
+// 'game_repetition_stack' holds the game's positions up to and including 'current_board_state'.
 AiMoveResult find_best_ai_move(
     const BoardState& current_board_state, 
-    int search_depth,
-    const std::vector<BoardState>& game_history_ref // <<<< ADDED for repetition checking
+    const SearchLimits& limits,
+    const RepetitionStack& game_repetition_stack
 );
 
+// Forgets the killers, history and countermoves of every search thread. Call when another game
+// is loaded, so its searches do not start from the old game's move ordering.
+void clear_move_ordering();
+
 
 #endif // AI_H
 
@@ -0,0 +1,124 @@
+// bbdsq/attack_tables.h
+#ifndef ATTACK_TABLES_H
+#define ATTACK_TABLES_H
+
+#include "bitboard.h" // For U64, BOARD_WIDTH, BOARD_HEIGHT, NUM_SQUARES, get_square_index
+#include <array>
+
+// Per-square move tables, computed at compile time from the board geometry.
+// Unlike the masks in bitboard.h they need no init_masks() call: the lake, the board edges
+// and the jump lanes never change, so move generation only has to look a square up and
+// AND the result with occupancy, rat and den masks.
+
+namespace AttackTables {
+
+    // Lake: rows 3-5 (ranks 4-6), columns B, C, E, F. Same squares as LAKE_SQUARES_MASK.
+    constexpr bool is_lake_square(int col, int row) {
+        return row >= 3 && row <= 5 && (col == 1 || col == 2 || col == 4 || col == 5);
+    }
+
+    // Orthogonal directions: north, south, east, west
+    constexpr int NUM_DIRECTIONS = 4;
+    constexpr int DIRECTION_COL[NUM_DIRECTIONS] = {0, 0, 1, -1};
+    constexpr int DIRECTION_ROW[NUM_DIRECTIONS] = {1, -1, 0, 0};
+
+    constexpr bool on_board(int col, int row) {
+        return col >= 0 && col < BOARD_WIDTH && row >= 0 && row < BOARD_HEIGHT;
+    }
+
+    // Orthogonal neighbours of each square; lake squares are left out unless 'include_lake'.
+    constexpr std::array<U64, NUM_SQUARES> compute_step_targets(bool include_lake) {
+        std::array<U64, NUM_SQUARES> table{};
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            int col = sq % BOARD_WIDTH;
+            int row = sq / BOARD_WIDTH;
+            U64 targets = 0ULL;
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+                int to_col = col + DIRECTION_COL[dir];
+                int to_row = row + DIRECTION_ROW[dir];
+                if (!on_board(to_col, to_row)) continue;
+                if (!include_lake && is_lake_square(to_col, to_row)) continue;
+                targets |= 1ULL << get_square_index(to_col, to_row);
+            }
+            table[sq] = targets;
+        }
+        return table;
+    }
+
+    // Step targets of every piece except the rat (land only) and of the rat (land and lake).
+    // Neither excludes the own den or friendly pieces; that depends on the position.
+    constexpr std::array<U64, NUM_SQUARES> LAND_STEP_TARGETS = compute_step_targets(false);
+    constexpr std::array<U64, NUM_SQUARES> RAT_STEP_TARGETS = compute_step_targets(true);
+
+    // Lion/tiger jumps from one square: the landing square of each jump and the lake squares
+    // it crosses. A jump is open when no rat (of either side) stands on its lake path.
+    struct JumpList {
+        int count;
+        int landing_sq[NUM_DIRECTIONS];
+        U64 lake_path[NUM_DIRECTIONS];
+    };
+
+    // A jump runs straight from a land square across one or more lake squares to the first
+    // land square behind them.
+    constexpr std::array<JumpList, NUM_SQUARES> compute_jumps() {
+        std::array<JumpList, NUM_SQUARES> table{};
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            int col = sq % BOARD_WIDTH;
+            int row = sq / BOARD_WIDTH;
+            JumpList& jumps = table[sq];
+            jumps.count = 0;
+            if (is_lake_square(col, row)) continue; // Lions and tigers never stand in the lake
+
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+                int to_col = col + DIRECTION_COL[dir];
+                int to_row = row + DIRECTION_ROW[dir];
+                U64 path = 0ULL;
+                while (on_board(to_col, to_row) && is_lake_square(to_col, to_row)) {
+                    path |= 1ULL << get_square_index(to_col, to_row);
+                    to_col += DIRECTION_COL[dir];
+                    to_row += DIRECTION_ROW[dir];
+                }
+                if (path == 0ULL || !on_board(to_col, to_row)) continue;
+                jumps.landing_sq[jumps.count] = get_square_index(to_col, to_row);
+                jumps.lake_path[jumps.count] = path;
+                jumps.count++;
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<JumpList, NUM_SQUARES> LION_TIGER_JUMPS = compute_jumps();
+
+    // Landing squares of all jumps from 'sq' that no rat blocks.
+    inline U64 open_jump_targets(int sq, U64 all_rat_occupancy) {
+        const JumpList& jumps = LION_TIGER_JUMPS[sq];
+        U64 targets = 0ULL;
+        for (int i = 0; i < jumps.count; ++i) {
+            if ((jumps.lake_path[i] & all_rat_occupancy) == 0ULL) {
+                targets |= 1ULL << jumps.landing_sq[i];
+            }
+        }
+        return targets;
+    }
+
+    // Sanity checks on the geometry.
+    constexpr int count_bits(U64 bb) {
+        int count = 0;
+        for (; bb != 0ULL; bb &= bb - 1) count++;
+        return count;
+    }
+    static_assert(count_bits(RAT_STEP_TARGETS[get_square_index(3, 4)]) == 4 &&
+                  count_bits(LAND_STEP_TARGETS[get_square_index(3, 4)]) == 2,
+                  "D5 must border two lake squares");
+    static_assert(LION_TIGER_JUMPS[get_square_index(1, 2)].count == 1 &&
+                  LION_TIGER_JUMPS[get_square_index(1, 2)].landing_sq[0] == get_square_index(1, 6),
+                  "B3 must jump to B7");
+    static_assert(LION_TIGER_JUMPS[get_square_index(0, 3)].count == 1 &&
+                  LION_TIGER_JUMPS[get_square_index(0, 3)].landing_sq[0] == get_square_index(3, 3),
+                  "A4 must jump to D4");
+    static_assert(LION_TIGER_JUMPS[get_square_index(3, 4)].count == 2, "D5 must jump both ways");
+    static_assert(LION_TIGER_JUMPS[get_square_index(3, 2)].count == 0, "D3 has no lake ahead of it");
+
+} // namespace AttackTables
+
+#endif // ATTACK_TABLES_H
@@ -6,15 +6,13 @@
 #include <iostream>  // For error messages and success messages
 #include <stdexcept> // For std::stoi, std::stoull exceptions
 
-// A simple version marker for the save file format
-const int CURRENT_SAVE_FORMAT_VERSION = 1;
+// A simple version marker for the save file format.
+// Version 1 stored every position as 18 bitboards plus the side to move; version 2 stores one
+// PackedPosition per line. Version 1 files are still loaded.
+const int CURRENT_SAVE_FORMAT_VERSION = 2;
+const int BITBOARD_SAVE_FORMAT_VERSION = 1;
 
-// Helper to write a U64 to stream as a hex string on a new line
-void write_u64_hex_to_stream(std::ostream& os, U64 val) {
-    os << "0x" << std::hex << std::setw(16) << std::setfill('0') << val << std::dec << std::endl;
-}
-
-// Helper to read a U64 from stream (expects "0x" prefixed hex string on its own line)
+// Helper to read a U64 from stream (format version 1; expects "0x" prefixed hex string on its own line)
 bool read_u64_hex_from_stream(std::istream& is, U64& val) {
     std::string line;
     if (!std::getline(is, line) || line.empty()) {
@@ -38,21 +36,14 @@ bool read_u64_hex_from_stream(std::istream& is, U64& val) {
     return true;
 }
 
-// Helper to save a single BoardState object
-void save_single_board_state(std::ostream& os, const BoardState& bs) {
-    for (int pt = 0; pt < NUM_PIECE_TYPES; ++pt) {
-        write_u64_hex_to_stream(os, bs.piece_bbs[pt][PLAYER_1]);
-        write_u64_hex_to_stream(os, bs.piece_bbs[pt][PLAYER_2]);
-    }
-    os << static_cast<int>(bs.side_to_move) << std::endl;
-}
-
-// Helper to load a single BoardState object
+// Helper to load a single BoardState object (format version 1)
 bool load_single_board_state(std::istream& is, BoardState& bs) {
-    for (int pt = 0; pt < NUM_PIECE_TYPES; ++pt) {
-        if (!read_u64_hex_from_stream(is, bs.piece_bbs[pt][PLAYER_1])) return false;
-        if (!read_u64_hex_from_stream(is, bs.piece_bbs[pt][PLAYER_2])) return false;
-        bs.piece_bbs[pt][NO_PLAYER] = 0ULL; 
+    U64 no_piece_type_bb = 0ULL; // Leading NO_PIECE_TYPE pair of the format, always empty
+    if (!read_u64_hex_from_stream(is, no_piece_type_bb)) return false;
+    if (!read_u64_hex_from_stream(is, no_piece_type_bb)) return false;
+    for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+        if (!read_u64_hex_from_stream(is, bs.piece_bb(pt, PLAYER_1))) return false;
+        if (!read_u64_hex_from_stream(is, bs.piece_bb(pt, PLAYER_2))) return false;
     }
     int side_to_move_int;
     std::string line;
@@ -69,9 +60,73 @@ bool load_single_board_state(std::istream& is, BoardState& bs) {
 }
 
 
+// Helper to save a single PackedPosition on one line: 16 two-digit hex squares
+// (PLAYER_1 rat..elephant, then PLAYER_2; "ff" for a captured piece), a space and the side to move.
+void save_packed_position(std::ostream& os, const PackedPosition& pos) {
+    os << std::hex << std::setfill('0');
+    for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+        for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+            os << std::setw(2) << static_cast<int>(pos.square_of(pt, p));
+        }
+    }
+    os << std::dec << ' ' << static_cast<int>(pos.side_to_move) << std::endl;
+}
+
+// Helper to load a single PackedPosition written by save_packed_position
+bool load_packed_position(std::istream& is, PackedPosition& pos) {
+    std::string line;
+    if (!std::getline(is, line)) return false;
+    line.erase(line.find_last_not_of(" \t\n\r\f\v") + 1);
+
+    const size_t num_square_digits = 2 * 2 * (NUM_PIECE_TYPES - 1);
+    if (line.length() < num_square_digits + 2 || line[num_square_digits] != ' ') {
+        std::cerr << "Read Error: Malformed packed position line: \"" << line << "\"" << std::endl;
+        return false;
+    }
+    for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+        for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+            size_t offset = 2 * ((p - 1) * (NUM_PIECE_TYPES - 1) + (pt - 1));
+            unsigned long sq = 0;
+            try {
+                size_t parsed = 0;
+                sq = std::stoul(line.substr(offset, 2), &parsed, 16);
+                if (parsed != 2) throw std::invalid_argument("short square");
+            } catch (const std::exception& e) {
+                std::cerr << "Read Error: Bad square in packed position \"" << line << "\": " << e.what() << std::endl;
+                return false;
+            }
+            if (sq >= NUM_SQUARES && sq != PackedPosition::NO_SQUARE) {
+                std::cerr << "Read Error: Square out of range in packed position \"" << line << "\"" << std::endl;
+                return false;
+            }
+            pos.squares[p - 1][pt - 1] = static_cast<uint8_t>(sq);
+        }
+    }
+    std::stringstream ss_side(line.substr(num_square_digits + 1));
+    int side_to_move_int;
+    if (!(ss_side >> side_to_move_int) || !ss_side.eof() || side_to_move_int < NO_PLAYER || side_to_move_int > PLAYER_2) {
+        std::cerr << "Read Error: Failed to parse side_to_move of packed position \"" << line << "\"" << std::endl;
+        return false;
+    }
+    pos.side_to_move = static_cast<uint8_t>(side_to_move_int);
+    return true;
+}
+
+// Helper to load one position in the encoding of the given file version
+bool load_position_for_version(std::istream& is, int version, PackedPosition& pos) {
+    if (version == BITBOARD_SAVE_FORMAT_VERSION) {
+        BoardState bs;
+        if (!load_single_board_state(is, bs)) return false;
+        pos = PackedPosition::from_board(bs);
+        return true;
+    }
+    return load_packed_position(is, pos);
+}
+
+
 bool save_game_state(
     const BoardState& board_state_to_save,
-    const std::vector<BoardState>& history_to_save,
+    const std::vector<PackedPosition>& history_to_save,
     int current_history_ply_to_save,
     bool game_over_status_to_save,
     Player winner_status_to_save,
@@ -85,8 +140,8 @@ bool save_game_state(
 
     outfile << "DSQSaveFormatVersion: " << CURRENT_SAVE_FORMAT_VERSION << std::endl;
     
-    outfile << "CurrentBoardStateMarker:" << std::endl; 
-    save_single_board_state(outfile, board_state_to_save);
+    outfile << "CurrentPositionMarker:" << std::endl; 
+    save_packed_position(outfile, PackedPosition::from_board(board_state_to_save));
 
     outfile << "GameOverStatus: " << (game_over_status_to_save ? 1 : 0) << std::endl;
     outfile << "WinnerStatus: " << static_cast<int>(winner_status_to_save) << std::endl;
@@ -94,9 +149,9 @@ bool save_game_state(
     outfile << "HistorySize: " << history_to_save.size() << std::endl;
     outfile << "CurrentHistoryPly: " << current_history_ply_to_save << std::endl;
     
-    outfile << "HistoryStatesMarker:" << std::endl; 
-    for (const auto& hist_state : history_to_save) {
-        save_single_board_state(outfile, hist_state);
+    outfile << "HistoryPositionsMarker:" << std::endl; 
+    for (const auto& hist_position : history_to_save) {
+        save_packed_position(outfile, hist_position);
     }
 
     outfile.close();
@@ -107,7 +162,7 @@ bool save_game_state(
 
 bool load_game_state(
     BoardState& board_state_to_load_into,
-    std::vector<BoardState>& history_to_load_into,
+    std::vector<PackedPosition>& history_to_load_into,
     int& current_history_ply_to_load_into,
     bool& game_over_status_to_load_into,
     Player& winner_status_to_load_into,
@@ -134,17 +189,23 @@ bool load_game_state(
         infile.close(); return false;
     }
 
-    if (version != CURRENT_SAVE_FORMAT_VERSION) {
-        std::cerr << "Error: Unknown save file version " << version << ". Expected " << CURRENT_SAVE_FORMAT_VERSION << "." << std::endl;
+    if (version != CURRENT_SAVE_FORMAT_VERSION && version != BITBOARD_SAVE_FORMAT_VERSION) {
+        std::cerr << "Error: Unknown save file version " << version << ". Expected " << BITBOARD_SAVE_FORMAT_VERSION
+                  << " or " << CURRENT_SAVE_FORMAT_VERSION << "." << std::endl;
         infile.close(); return false;
     }
+    const bool is_bitboard_format = (version == BITBOARD_SAVE_FORMAT_VERSION);
 
-    if (!std::getline(infile, line) || line != "CurrentBoardStateMarker:") { 
-        std::cerr << "Error: Missing CurrentBoardStateMarker. Got: \"" << line << "\"" << std::endl; infile.close(); return false; 
+    const std::string current_marker = is_bitboard_format ? "CurrentBoardStateMarker:" : "CurrentPositionMarker:";
+    if (!std::getline(infile, line) || line != current_marker) { 
+        std::cerr << "Error: Missing " << current_marker << " Got: \"" << line << "\"" << std::endl; infile.close(); return false; 
     }
-    if (!load_single_board_state(infile, board_state_to_load_into)) {
+    PackedPosition current_position;
+    if (!load_position_for_version(infile, version, current_position)) {
         std::cerr << "Error loading current board state." << std::endl; infile.close(); return false;
     }
+    // Rebuilt through the packed form, so occupancy, mailbox and Zobrist hash are all set.
+    board_state_to_load_into = current_position.to_board();
 
     if (!std::getline(infile, line) || line.find("GameOverStatus: ") != 0) { 
         std::cerr << "Error: Missing or malformed GameOverStatus line: \"" << line << "\"" << std::endl; infile.close(); return false; 
@@ -189,17 +250,18 @@ bool load_game_state(
         infile.close(); return false;
     }
     
-    if (!std::getline(infile, line) || line != "HistoryStatesMarker:") { 
-        std::cerr << "Error: Missing HistoryStatesMarker. Got: \"" << line << "\"" << std::endl; infile.close(); return false; 
+    const std::string history_marker = is_bitboard_format ? "HistoryStatesMarker:" : "HistoryPositionsMarker:";
+    if (!std::getline(infile, line) || line != history_marker) { 
+        std::cerr << "Error: Missing " << history_marker << " Got: \"" << line << "\"" << std::endl; infile.close(); return false; 
     }
 
     history_to_load_into.reserve(history_size);
     for (size_t i = 0; i < history_size; ++i) {
-        BoardState hist_state; 
-        if (!load_single_board_state(infile, hist_state)) {
+        PackedPosition hist_position; 
+        if (!load_position_for_version(infile, version, hist_position)) {
              std::cerr << "Error loading history state #" << i << std::endl; infile.close(); return false;
         }
-        history_to_load_into.push_back(hist_state);
+        history_to_load_into.push_back(hist_position);
     }
 
     // Check if we read exactly the number of history states expected
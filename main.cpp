@@ -6,6 +6,7 @@
 #include <vector>      
 #include <iomanip>     
 #include <stdexcept>   
+#include <algorithm>   // For std::max
 
 #include "bitboard.h" 
 #include "piece.h"    
@@ -16,6 +17,8 @@
 #include "gui.h"            
 #include "zobrist.h" 
 #include "ttable.h" 
+#include "repetition.h"
+#include "packed_position.h"
 
 // --- Debug Logging Macros ---
 #ifndef NDEBUG 
@@ -38,21 +41,33 @@
 
 // --- Global variable for search depth & TT size, can be overridden by command line ---
 int g_search_depth = DEFAULT_AI_SEARCH_DEPTH; 
+bool g_search_depth_given = false;  // --depth caps time-controlled searches only when given explicitly
+long long g_movetime_ms = 0;        // --movetime: fixed thinking time per AI move (0 = off)
+long long g_clock_increment_ms = 0; // --timecontrol: increment added to the AI clock after each move
+long long g_ai_clock_ms = 0;        // --timecontrol: AI's remaining game clock (may run down to 0)
+bool g_timecontrol_enabled = false; // --timecontrol given: the AI plays on its game clock
+int g_search_threads = 1;           // --threads: Lazy SMP search threads
+bool g_use_null_move = true;        // --no-null-move: disables null-move pruning (A/B testing)
+bool g_use_late_move_reductions = true; // --no-lmr: disables late move reductions and pruning
+double g_lmr_base = DEFAULT_LMR_BASE;       // --lmr: reduction table parameters
+double g_lmr_divisor = DEFAULT_LMR_DIVISOR;
+bool g_use_futility_pruning = true;  // --no-futility: disables futility pruning and razoring
 bool g_human_starts_game = false; 
 size_t g_tt_size_mb = 256; // Default TT size in MB
+std::string g_tt_snapshot_file;     // --ttsnapshot: TT saved here at exit and loaded at start (empty = off)
 
 // --- Game State Variables ---
 BoardState current_board_state; 
 int selected_square = -1; 
 U64 possible_moves_bb = 0ULL; 
-std::vector<Move> current_player_valid_moves; 
+MoveList current_player_valid_moves; 
 
 bool confirm_quit_active = false;
 bool game_over = false;
 Player winner = NO_PLAYER; 
 Move last_ai_move; 
 
-std::vector<BoardState> game_history; 
+std::vector<PackedPosition> game_history; // 17 bytes per ply, see packed_position.h
 int current_history_index = -1;    
 bool ai_should_think_automatically = true; 
 
@@ -63,8 +78,24 @@ void print_help_message(const char* program_name) {
     std::cout << "Options:" << std::endl;
     std::cout << "  --depth <number>   Set AI search depth in plies (1-50)." << std::endl;
     std::cout << "                     Defaults to " << DEFAULT_AI_SEARCH_DEPTH << " if not specified." << std::endl;
+    std::cout << "  --movetime <ms>    Let the AI think for a fixed time per move (iterative deepening)." << std::endl;
+    std::cout << "  --timecontrol <base>+<inc>" << std::endl;
+    std::cout << "                     Give the AI a game clock of <base> seconds plus <inc> seconds" << std::endl;
+    std::cout << "                     per move (e.g. 300+5). With a time limit, --depth is only a cap." << std::endl;
+    std::cout << "                     The clock is not restored by takebacks or when a saved game is loaded." << std::endl;
+    std::cout << "  --threads <N>      Search with N threads sharing the Transposition Table (1-" << MAX_SEARCH_THREADS << ")." << std::endl;
+    std::cout << "                     Defaults to 1." << std::endl;
+    std::cout << "  --no-null-move     Disable null-move pruning in the search (for comparing time-to-depth)." << std::endl;
+    std::cout << "  --no-lmr           Disable late move reductions and late move pruning in the search." << std::endl;
+    std::cout << "  --no-futility      Disable futility pruning and razoring near the search horizon." << std::endl;
+    std::cout << "  --lmr <base>,<div> Tune the late move reductions: a quiet move is reduced by" << std::endl;
+    std::cout << "                     base + ln(depth) * ln(move number) / div plies. Defaults to "
+              << DEFAULT_LMR_BASE << "," << DEFAULT_LMR_DIVISOR << "." << std::endl;
     std::cout << "  --ttsize <MB>      Set Transposition Table size in Megabytes (1-16384)." << std::endl;
     std::cout << "                     Defaults to 256 MB if not specified." << std::endl;
+    std::cout << "  --ttsnapshot <file>" << std::endl;
+    std::cout << "                     Save the Transposition Table to <file> on exit and load it on start," << std::endl;
+    std::cout << "                     so a resumed game keeps the earlier analysis." << std::endl;
     std::cout << "  --me               Human player (Player 2, Brown) makes the first move." << std::endl;
     std::cout << "  -h, --help         Show this help message and exit." << std::endl;
 }
@@ -80,21 +111,30 @@ void record_current_state_in_history() {
     }
 
     if (history_was_truncated) { // New move after undoing past some states
-        TranspositionTable::clear_tt();
-        std::cout << "Info: History diverged due to new move after undo, Transposition Table cleared." << std::endl;
+        // Entries are keyed by position, so they stay usable; a new generation just lets the
+        // replacement policy age them out instead of a full clear.
+        TranspositionTable::new_search();
+        std::cout << "Info: History diverged due to new move after undo, Transposition Table generation advanced." << std::endl;
     }
 
-    BoardState state_to_record = current_board_state; 
-    game_history.push_back(state_to_record); 
+    game_history.push_back(PackedPosition::from_board(current_board_state)); 
     current_history_index = static_cast<int>(game_history.size()) - 1;
     DEBUG_LOG << "DEBUG: Recorded state. History size: " << game_history.size() << ", Idx: " << current_history_index 
-              << ", Side: P" << static_cast<int>(state_to_record.side_to_move) 
-              << ", Hash: 0x" << std::hex << state_to_record.zobrist_hash << std::dec << std::endl;
+              << ", Side: P" << static_cast<int>(current_board_state.side_to_move) 
+              << ", Hash: 0x" << std::hex << current_board_state.zobrist_hash << std::dec << std::endl;
+}
+
+// Repetition stack for the position currently on the board: the history up to current_history_index.
+// States after it (kept for redo) have not happened in this line of play and must not count.
+RepetitionStack build_current_repetition_stack() {
+    RepetitionStack stack;
+    stack.reset_from_game_history(game_history, current_history_index);
+    return stack;
 }
 
 void apply_state_from_history(int history_idx) {
     if (history_idx >= 0 && history_idx < static_cast<int>(game_history.size())) {
-        current_board_state = game_history[history_idx]; 
+        current_board_state = game_history[history_idx].to_board(); 
         current_history_index = history_idx;
         
         game_over = false; 
@@ -128,8 +168,8 @@ void apply_state_from_history(int history_idx) {
         possible_moves_bb = 0ULL;
         current_player_valid_moves.clear();
         last_ai_move = Move(); 
-        // TT is NOT cleared here, as we are just navigating existing history.
-        // It's cleared if a *new move* is made from an undone state (handled in record_current_state_in_history).
+        // TT is NOT touched here, as we are just navigating existing history.
+        // Its generation advances if a *new move* is made from an undone state (handled in record_current_state_in_history).
         std::cout << "Applied state from history index " << history_idx << ". Side to move: P" << static_cast<int>(current_board_state.side_to_move) 
                   << ". Game over: " << (game_over ? "true" : "false") << ", Winner: " << static_cast<int>(winner) << std::endl;
     } else {
@@ -152,6 +192,7 @@ int main(int argc, char* argv[]) {
                     int depth_val = std::stoi(args[i + 1]);
                     if (depth_val >= 1 && depth_val <= 50) { 
                         g_search_depth = depth_val;
+                        g_search_depth_given = true;
                     } else {
                         std::cerr << "Error: Depth value " << args[i + 1] << " out of range (1-50)." << std::endl;
                         print_help_message(argv[0]);
@@ -198,6 +239,125 @@ int main(int argc, char* argv[]) {
                 print_help_message(argv[0]);
                 return 1;
             }
+        } else if (arg == "--movetime") {
+            if (i + 1 < args.size()) {
+                try {
+                    long long movetime_val = std::stoll(args[i + 1]);
+                    if (movetime_val >= 1) {
+                        g_movetime_ms = movetime_val;
+                    } else {
+                        std::cerr << "Error: --movetime value " << args[i + 1] << " must be at least 1 ms." << std::endl;
+                        print_help_message(argv[0]);
+                        return 1;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid number for --movetime: " << args[i + 1] << std::endl;
+                    print_help_message(argv[0]);
+                    return 1;
+                }
+                i++;
+            } else {
+                std::cerr << "Error: --movetime option requires a value (ms)." << std::endl;
+                print_help_message(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--timecontrol") {
+            if (i + 1 < args.size()) {
+                const std::string& tc = args[i + 1];
+                size_t plus_pos = tc.find('+');
+                try {
+                    size_t parsed_chars = 0;
+                    std::string base_str = tc.substr(0, plus_pos);
+                    double base_s = std::stod(base_str, &parsed_chars);
+                    if (parsed_chars != base_str.size()) throw std::invalid_argument(tc);
+                    double inc_s = 0.0;
+                    if (plus_pos != std::string::npos) {
+                        std::string inc_str = tc.substr(plus_pos + 1);
+                        inc_s = std::stod(inc_str, &parsed_chars);
+                        if (parsed_chars != inc_str.size()) throw std::invalid_argument(tc);
+                    }
+                    if (base_s <= 0.0 || inc_s < 0.0) {
+                        std::cerr << "Error: --timecontrol needs a positive base time and a non-negative increment." << std::endl;
+                        print_help_message(argv[0]);
+                        return 1;
+                    }
+                    g_ai_clock_ms = static_cast<long long>(base_s * 1000.0);
+                    g_timecontrol_enabled = true;
+                    g_clock_increment_ms = static_cast<long long>(inc_s * 1000.0);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid --timecontrol value: " << tc << " (expected <base>+<inc> in seconds)" << std::endl;
+                    print_help_message(argv[0]);
+                    return 1;
+                }
+                i++;
+            } else {
+                std::cerr << "Error: --timecontrol option requires a value (<base>+<inc> in seconds)." << std::endl;
+                print_help_message(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--threads") {
+            if (i + 1 < args.size()) {
+                try {
+                    int threads_val = std::stoi(args[i + 1]);
+                    if (threads_val >= 1 && threads_val <= MAX_SEARCH_THREADS) {
+                        g_search_threads = threads_val;
+                    } else {
+                        std::cerr << "Error: --threads value " << args[i + 1] << " out of range (1-" << MAX_SEARCH_THREADS << ")." << std::endl;
+                        print_help_message(argv[0]);
+                        return 1;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid number for --threads: " << args[i + 1] << std::endl;
+                    print_help_message(argv[0]);
+                    return 1;
+                }
+                i++;
+            } else {
+                std::cerr << "Error: --threads option requires a value." << std::endl;
+                print_help_message(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--ttsnapshot") {
+            if (i + 1 < args.size()) {
+                g_tt_snapshot_file = args[i + 1];
+                i++;
+            } else {
+                std::cerr << "Error: --ttsnapshot option requires a file name." << std::endl;
+                print_help_message(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--no-null-move") {
+            g_use_null_move = false;
+        } else if (arg == "--no-futility") {
+            g_use_futility_pruning = false;
+        } else if (arg == "--no-lmr") {
+            g_use_late_move_reductions = false;
+        } else if (arg == "--lmr") {
+            if (i + 1 < args.size()) {
+                const std::string& lmr = args[i + 1];
+                size_t comma_pos = lmr.find(',');
+                try {
+                    if (comma_pos == std::string::npos) throw std::invalid_argument("missing ','");
+                    double base = std::stod(lmr.substr(0, comma_pos));
+                    double divisor = std::stod(lmr.substr(comma_pos + 1));
+                    if (base < 0.0 || base > 10.0 || divisor <= 0.0 || divisor > 100.0) {
+                        std::cerr << "Error: --lmr values out of range (base 0-10, divisor above 0 and up to 100): " << lmr << std::endl;
+                        print_help_message(argv[0]);
+                        return 1;
+                    }
+                    g_lmr_base = base;
+                    g_lmr_divisor = divisor;
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid --lmr value: " << lmr << " (expected <base>,<divisor>)" << std::endl;
+                    print_help_message(argv[0]);
+                    return 1;
+                }
+                i++;
+            } else {
+                std::cerr << "Error: --lmr option requires a value (<base>,<divisor>)." << std::endl;
+                print_help_message(argv[0]);
+                return 1;
+            }
         } else if (arg == "--me") {
             g_human_starts_game = true;
         }
@@ -210,6 +370,26 @@ int main(int argc, char* argv[]) {
     if (g_search_depth != DEFAULT_AI_SEARCH_DEPTH) { 
         std::cout << "AI search depth set to " << g_search_depth << " plies from command line." << std::endl;
     }
+    if (g_movetime_ms > 0) {
+        std::cout << "AI move time set to " << g_movetime_ms << " ms from command line." << std::endl;
+    } else if (g_timecontrol_enabled) {
+        std::cout << "AI game clock set to " << g_ai_clock_ms << " ms + " << g_clock_increment_ms << " ms per move from command line." << std::endl;
+    }
+    if (g_search_threads != 1) {
+        std::cout << "AI search threads set to " << g_search_threads << " from command line." << std::endl;
+    }
+    if (!g_use_null_move) {
+        std::cout << "Null-move pruning disabled from command line." << std::endl;
+    }
+    if (!g_use_futility_pruning) {
+        std::cout << "Futility pruning and razoring disabled from command line." << std::endl;
+    }
+    if (!g_use_late_move_reductions) {
+        std::cout << "Late move reductions and pruning disabled from command line." << std::endl;
+    } else if (g_lmr_base != DEFAULT_LMR_BASE || g_lmr_divisor != DEFAULT_LMR_DIVISOR) {
+        std::cout << "Late move reduction table set to " << g_lmr_base << " + ln(depth) * ln(move) / "
+                  << g_lmr_divisor << " from command line." << std::endl;
+    }
     if (g_tt_size_mb != 256) { // Assuming 256 was the default before this param
         std::cout << "Transposition Table size set to " << g_tt_size_mb << " MB from command line." << std::endl;
     }
@@ -217,7 +397,11 @@ int main(int argc, char* argv[]) {
 
     Zobrist::initialize_keys(); 
     init_masks();               
+    init_psts();                // Material + PST table, before any board is set up
     TranspositionTable::initialize_tt(g_tt_size_mb); 
+    if (!g_tt_snapshot_file.empty()) {
+        TranspositionTable::load_tt_snapshot(g_tt_snapshot_file);
+    }
     
     const std::string local_font_path = "arial-monospace.ttf"; 
     const std::string system_font_path = "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf";
@@ -244,14 +428,13 @@ int main(int argc, char* argv[]) {
         current_history_index = -1; 
         ai_should_think_automatically = (current_board_state.side_to_move != PLAYER_1 || game_over); 
         record_current_state_in_history();    
-        TranspositionTable::clear_tt(); 
     } else {
         std::cout << "Previous game loaded." << std::endl;
         if (current_history_index >= 0 && current_history_index < static_cast<int>(game_history.size())) {
-            current_board_state = game_history[current_history_index];
+            current_board_state = game_history[current_history_index].to_board();
         } else if (!game_history.empty()) { 
              current_history_index = static_cast<int>(game_history.size()) -1;
-             if (current_history_index >=0) current_board_state = game_history[current_history_index];
+             if (current_history_index >=0) current_board_state = game_history[current_history_index].to_board();
              else { current_board_state.setup_initial_board(); record_current_state_in_history(); }
         } else { current_board_state.setup_initial_board(); record_current_state_in_history(); }
         if (current_board_state.side_to_move == NO_PLAYER && !game_over) { game_over = true; }
@@ -259,7 +442,6 @@ int main(int argc, char* argv[]) {
         if (current_board_state.side_to_move == PLAYER_1 && !game_over) {
             std::cout << "Game loaded to AI's turn. Press 'G' for AI to move." << std::endl;
         }
-        TranspositionTable::clear_tt(); 
     }
 
     sf::RenderWindow window(sf::VideoMode(GUI::get_initial_window_width(), GUI::get_initial_window_height()), "bbdsq");
@@ -304,7 +486,8 @@ int main(int argc, char* argv[]) {
                         if(load_game_state(current_board_state, game_history, current_history_index, game_over, winner)) {
                             selected_square = -1; possible_moves_bb = 0ULL; current_player_valid_moves.clear(); last_ai_move = Move(); 
                             ai_should_think_automatically = !(current_board_state.side_to_move == PLAYER_1 && !game_over);
-                            TranspositionTable::clear_tt(); 
+                            TranspositionTable::new_search(); // Age out the old game's entries
+                            clear_move_ordering();            // ... and its killers, history and countermoves
                             if (current_board_state.side_to_move == PLAYER_1 && !game_over) {
                                 std::cout << "Game loaded to AI's turn. Press 'G' for AI to move." << std::endl;
                             }
@@ -421,7 +604,7 @@ int main(int argc, char* argv[]) {
                                         Piece p_on_sq = current_board_state.get_piece_at(clicked_sq_idx);
                                         if (p_on_sq.player == player_whose_turn_it_is) { 
                                             selected_square = clicked_sq_idx;
-                                            current_player_valid_moves = generate_all_legal_moves(current_board_state, player_whose_turn_it_is, game_history);
+                                            generate_all_legal_moves(current_board_state, player_whose_turn_it_is, build_current_repetition_stack(), current_player_valid_moves);
                                             
                                             possible_moves_bb = 0ULL; 
                                             bool found_moves_for_this_piece = false;
@@ -454,23 +637,66 @@ int main(int argc, char* argv[]) {
                     else if (current_board_state.side_to_move == PLAYER_1) {
                         if (ai_should_think_automatically) {
                             std::cout << "\nPlayer 1 (AI) is thinking..." << std::endl;
-                            AiMoveResult ai_result = find_best_ai_move(current_board_state, g_search_depth, game_history); 
+                            SearchLimits limits;
+                            limits.movetime_ms = g_movetime_ms;
+                            if (g_movetime_ms == 0 && g_timecontrol_enabled) {
+                                // An exhausted clock still counts as a time limit: the search then
+                                // gets compute_time_budget's minimum instead of running to full depth.
+                                limits.time_left_ms = std::max(1LL, g_ai_clock_ms);
+                                limits.increment_ms = g_clock_increment_ms;
+                            }
+                            limits.max_depth = (limits.is_time_limited() && !g_search_depth_given) ? MAX_SEARCH_DEPTH : g_search_depth;
+                            limits.num_threads = g_search_threads;
+                            limits.use_null_move = g_use_null_move;
+                            limits.use_late_move_reductions = g_use_late_move_reductions;
+                            limits.lmr_base = g_lmr_base;
+                            limits.lmr_divisor = g_lmr_divisor;
+                            limits.use_futility_pruning = g_use_futility_pruning;
+
+                            AiMoveResult ai_result = find_best_ai_move(current_board_state, limits, build_current_repetition_stack()); 
                             last_ai_move = ai_result.best_move; 
+                            if (g_movetime_ms == 0 && g_timecontrol_enabled) {
+                                g_ai_clock_ms = std::max(0LL, g_ai_clock_ms - static_cast<long long>(ai_result.time_taken_ms)) + g_clock_increment_ms;
+                            }
 
                             std::cout << "------------------------------------" << std::endl;
                             std::cout << "AI Move Details (Player 1 - Grey):" << std::endl;
                             if (last_ai_move.from_sq != -1) { std::cout << "  Chosen Move: " << last_ai_move.to_string() << std::endl;} 
                             else { std::cout << "  No valid move chosen by AI (or stalemate)." << std::endl; }
                             std::cout << "  Projected Score: " << ai_result.final_score / 2.0 << " mc" << std::endl;
-                            std::cout << "  Nodes Searched: " << ai_result.nodes_searched << std::endl;
+                            std::cout << "  Depth Reached: " << ai_result.depth_reached << std::endl;
+                            for (const IterationInfo& iteration : ai_result.iterations) {
+                                std::cout << "    Depth " << std::setw(2) << iteration.depth << ": " << iteration.best_move.to_string()
+                                          << "  score " << iteration.score / 2.0 << " mc, " << iteration.nodes << " nodes, "
+                                          << iteration.time_ms << " ms" << std::endl;
+                            }
+                            std::cout << "  Nodes Searched: " << ai_result.nodes_searched;
+                            if (ai_result.threads_used > 1) { std::cout << " (" << ai_result.threads_used << " threads)"; }
+                            std::cout << std::endl;
                             std::cout << "  Time Taken: " << ai_result.time_taken_ms << " ms" << std::endl;
+                            if (g_movetime_ms == 0 && g_timecontrol_enabled) {
+                                std::cout << "  AI Clock Remaining: " << g_ai_clock_ms / 1000.0 << " s" << std::endl;
+                            }
                             std::cout << "  Root Moves Considered: " << ai_result.root_moves_count << std::endl;
                             if (ai_result.time_taken_ms > 0.001) { std::cout << "  Nodes per Second: " << static_cast<long long>(ai_result.nodes_searched / (ai_result.time_taken_ms / 1000.0)) << std::endl;} 
                             else { std::cout << "  Nodes per Second: N/A (time too short)" << std::endl; }
+                            if (ai_result.beta_cutoffs > 0) {
+                                std::cout << "  First-Move Cutoffs: " << ai_result.first_move_cutoffs << " / " << ai_result.beta_cutoffs
+                                          << " (" << std::fixed << std::setprecision(1)
+                                          << 100.0 * ai_result.first_move_cutoffs / ai_result.beta_cutoffs << "%)" << std::endl;
+                            }
+                            if (g_use_futility_pruning) {
+                                std::cout << "  Futility Prunes: " << ai_result.futility_prunes
+                                          << ", Razor Prunes: " << ai_result.razor_prunes << std::endl;
+                            }
                             // TT Stats
                             TranspositionTable::TTStats tt_stats = TranspositionTable::get_tt_stats();
                             std::cout << "  TT Entries Used: " << tt_stats.used_entries << " / " << tt_stats.total_entries 
                                       << " (" << std::fixed << std::setprecision(1) << tt_stats.utilization_percent << "%)" << std::endl;
+                            std::cout << "  TT Hashfull: " << tt_stats.hashfull_permille << " permille, Hits: " << tt_stats.probe_hits
+                                      << " / " << tt_stats.probes << " (" << tt_stats.hit_rate_percent << "%), Misses in Occupied Clusters: "
+                                      << tt_stats.cluster_misses << std::endl;
+                            std::cout << "  TT Stores: " << tt_stats.stores << ", Replacements: " << tt_stats.replacements << std::endl;
                             std::cout << "------------------------------------" << std::endl;
 
 
@@ -538,6 +764,11 @@ int main(int argc, char* argv[]) {
         window.display();
     }
 
+    std::cout << "Transposition Table huge pages at exit: "
+              << TranspositionTable::get_tt_huge_page_bytes() / (1024 * 1024) << " MB" << std::endl;
+    if (!g_tt_snapshot_file.empty()) {
+        TranspositionTable::save_tt_snapshot(g_tt_snapshot_file);
+    }
     TranspositionTable::cleanup_tt(); 
     return 0;
 }
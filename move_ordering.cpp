@@ -0,0 +1,117 @@
+// bbdsq/move_ordering.cpp
+#include "move_ordering.h"
+#include <algorithm> // For std::swap, std::min
+
+MoveOrdering::MoveOrdering() : cutoffs(0), first_move_cutoffs(0) {
+    clear();
+}
+
+void MoveOrdering::clear() {
+    for (int ply = 0; ply < MAX_PLY; ++ply) {
+        killers[ply][0] = Move();
+        killers[ply][1] = Move();
+    }
+    for (int p = 0; p < 3; ++p) {
+        for (int from = 0; from < NUM_SQUARES; ++from) {
+            for (int to = 0; to < NUM_SQUARES; ++to) {
+                history[p][from][to] = 0;
+                countermoves[p][from][to] = Move();
+            }
+        }
+    }
+    cutoffs = 0;
+    first_move_cutoffs = 0;
+}
+
+void MoveOrdering::new_search() {
+    const int PLIES_PER_AI_MOVE = 2; // Our move and the reply
+    for (int ply = 0; ply < MAX_PLY; ++ply) {
+        int source = ply + PLIES_PER_AI_MOVE;
+        killers[ply][0] = (source < MAX_PLY) ? killers[source][0] : Move();
+        killers[ply][1] = (source < MAX_PLY) ? killers[source][1] : Move();
+    }
+    for (int p = 0; p < 3; ++p) {
+        for (int from = 0; from < NUM_SQUARES; ++from) {
+            for (int to = 0; to < NUM_SQUARES; ++to) {
+                history[p][from][to] /= 2;
+            }
+        }
+    }
+    cutoffs = 0;
+    first_move_cutoffs = 0;
+}
+
+void MoveOrdering::score_moves(const MoveList& moves, const Move& tt_move, const Move& previous_move,
+                               Player player, int ply, U64 enemy_den_mask, std::array<int, MAX_MOVES>& scores) const {
+    const Move no_move;
+    const Move& killer_1 = (ply < MAX_PLY) ? killers[ply][0] : no_move;
+    const Move& killer_2 = (ply < MAX_PLY) ? killers[ply][1] : no_move;
+    const Move& countermove = (previous_move.from_sq != -1)
+        ? countermoves[player][previous_move.from_sq][previous_move.to_sq] : no_move;
+
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move& move = moves[i];
+        int score;
+        if (tt_move.from_sq != -1 && move.same_squares(tt_move)) {
+            score = TT_MOVE_SCORE;
+        } else if (get_bit(enemy_den_mask, move.to_sq)) {
+            score = DEN_ENTRY_SCORE;
+        } else if (move.piece_captured != NO_PIECE_TYPE) {
+            // Most valuable victim first, least valuable attacker among equal victims
+            score = CAPTURE_SCORE + PIECE_VALUES[move.piece_captured] * 16 - PIECE_RANKS[move.piece_moved];
+        } else if (move == killer_1) {
+            score = KILLER_SCORE;
+        } else if (move == killer_2) {
+            score = KILLER_SCORE - 1;
+        } else if (move == countermove) {
+            score = COUNTERMOVE_SCORE;
+        } else {
+            score = history[player][move.from_sq][move.to_sq];
+        }
+        scores[i] = score;
+    }
+}
+
+// "Gravity" update: the closer an entry already is to the limit in the bonus' direction,
+// the less it moves, so entries stay within +-MAX_HISTORY and old information fades.
+void MoveOrdering::update_history(int& entry, int bonus) {
+    int magnitude = bonus < 0 ? -bonus : bonus;
+    entry += bonus - entry * magnitude / MAX_HISTORY;
+}
+
+void MoveOrdering::update_on_cutoff(const MoveList& moves, int cutoff_index, U64 searched_moves,
+                                    const Move& previous_move, Player player, int ply, int depth) {
+    cutoffs++;
+    if (cutoff_index == 0) first_move_cutoffs++;
+
+    const Move& move = moves[cutoff_index];
+    if (move.piece_captured != NO_PIECE_TYPE) return; // Captures are ordered by MVV/LVA already
+
+    if (ply < MAX_PLY && !(killers[ply][0] == move)) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+    if (previous_move.from_sq != -1) {
+        countermoves[player][previous_move.from_sq][previous_move.to_sq] = move;
+    }
+
+    int bonus = std::min(depth * depth, MAX_HISTORY / 4);
+    update_history(history[player][move.from_sq][move.to_sq], bonus);
+    for (int i = 0; i < cutoff_index; ++i) {
+        const Move& tried = moves[i];
+        if (tried.piece_captured == NO_PIECE_TYPE && (searched_moves >> i) & 1ULL) {
+            update_history(history[player][tried.from_sq][tried.to_sq], -bonus);
+        }
+    }
+}
+
+void pick_next_move(MoveList& moves, std::array<int, MAX_MOVES>& scores, int index) {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    if (best != index) {
+        std::swap(moves[index], moves[best]);
+        std::swap(scores[index], scores[best]);
+    }
+}
@@ -0,0 +1,67 @@
+// bbdsq/move_ordering.h
+#ifndef MOVE_ORDERING_H
+#define MOVE_ORDERING_H
+
+#include "piece.h"   // For Player, PieceType, NUM_SQUARES
+#include "movegen.h" // For Move, MoveList, MAX_MOVES
+#include <array>
+
+// Move ordering heuristics of one search thread, for the interior nodes of alpha_beta_search:
+//  - killers: two quiet moves per ply that recently caused a beta cutoff there;
+//  - history: butterfly table [player][from][to], raised for quiet moves that cut off and
+//    lowered for the quiet moves searched before them;
+//  - countermoves: the quiet move that last refuted a given previous move [player][from][to].
+// The tables survive iterative-deepening iterations and consecutive AI moves; new_search()
+// only ages them, so each search starts from what the previous ones learned.
+struct MoveOrdering {
+    static const int MAX_PLY = 128;         // Killer slots; deeper plies simply get none
+    static const int MAX_HISTORY = 16384;   // History scores stay within +-MAX_HISTORY
+
+    // Ordering scores of the move classes, highest searched first. Quiet moves without a
+    // killer or countermove slot are ordered by their history score.
+    static const int TT_MOVE_SCORE = 1 << 30;
+    static const int DEN_ENTRY_SCORE = 1 << 29;
+    static const int CAPTURE_SCORE = 1 << 28;   // Plus MVV/LVA
+    static const int KILLER_SCORE = 1 << 27;    // First killer; the second one is one lower
+    static const int COUNTERMOVE_SCORE = 1 << 26;
+
+    Move killers[MAX_PLY][2];
+    int history[3][NUM_SQUARES][NUM_SQUARES];       // [Player][from][to]; [NO_PLAYER] unused
+    Move countermoves[3][NUM_SQUARES][NUM_SQUARES]; // [Player replying][previous from][previous to]
+
+    // Beta cutoffs at interior nodes in the current search, and how many of them came from the
+    // first move searched: first_move_cutoffs / cutoffs measures the ordering quality.
+    long long cutoffs;
+    long long first_move_cutoffs;
+
+    MoveOrdering();
+
+    // Forgets everything (another game was loaded, see clear_move_ordering in ai.h).
+    void clear();
+
+    // Start of a new AI move search: history is halved, killers move down two plies (this search's
+    // root was two plies deep in the previous one) and the cutoff counters restart.
+    void new_search();
+
+    // Scores every move in 'moves' for ordering at a node 'ply' plies below the root.
+    // 'tt_move' and 'previous_move' (the move that led here) may be null moves.
+    void score_moves(const MoveList& moves, const Move& tt_move, const Move& previous_move,
+                     Player player, int ply, U64 enemy_den_mask, std::array<int, MAX_MOVES>& scores) const;
+
+    // Records a beta cutoff by moves[cutoff_index] at 'depth'. 'searched_moves' has bit i set for
+    // each moves[i] actually searched: those before the cutoff failed, and quiet ones among them lose
+    // history. Moves skipped by pruning were never tried and keep their score.
+    void update_on_cutoff(const MoveList& moves, int cutoff_index, U64 searched_moves,
+                          const Move& previous_move, Player player, int ply, int depth);
+
+private:
+    void update_history(int& entry, int bonus);
+};
+
+static_assert(MAX_MOVES <= 64, "update_on_cutoff's searched_moves mask holds one bit per move");
+
+// Swaps the highest scored move among moves[index..] into moves[index] (selection sort step),
+// so a node that cuts off early never pays for sorting the whole list.
+void pick_next_move(MoveList& moves, std::array<int, MAX_MOVES>& scores, int index);
+
+#endif // MOVE_ORDERING_H
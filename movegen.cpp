@@ -1,320 +1,184 @@
 // bbdsq/movegen.cpp
 #include "movegen.h" // Includes piece.h (for BoardState, PieceType, Player, PIECE_RANKS, etc.)
                      // and bitboard.h (for U64, masks, etc.)
-#include <vector>
+#include "zobrist.h" // For computing the hash a move would lead to (repetition check)
+#include "attack_tables.h" // For the compile-time step and jump tables
 #include <iostream> 
 
 // Note: Global masks are extern U64 declared in bitboard.h and defined in bitboard.cpp.
 // They must be initialized (via init_masks()) before these functions are reliably used.
 
-U64 generate_orthogonal_step_moves(
-    int piece_square_idx, 
-    U64 friendly_occupancy, 
-    U64 land_squares_mask,  
-    U64 own_den_mask        
-) {
-    U64 moves_bb = 0ULL;
-    if (piece_square_idx < 0 || piece_square_idx >= NUM_SQUARES) return 0ULL;
-    U64 piece_bb = (1ULL << piece_square_idx); 
-
-    U64 north_target_sq_bb = 0ULL;
-    U64 south_target_sq_bb = 0ULL;
-    U64 east_target_sq_bb = 0ULL;
-    U64 west_target_sq_bb = 0ULL;
-
-    if (!(piece_bb & RANK_9_MASK)) north_target_sq_bb = (piece_bb << BOARD_WIDTH); 
-    if (!(piece_bb & RANK_1_MASK)) south_target_sq_bb = (piece_bb >> BOARD_WIDTH);
-    if (!(piece_bb & FILE_H_MASK)) east_target_sq_bb = (piece_bb << 1);
-    if (!(piece_bb & FILE_A_MASK)) west_target_sq_bb = (piece_bb >> 1);
-    
-    U64 potential_moves = north_target_sq_bb | south_target_sq_bb | east_target_sq_bb | west_target_sq_bb;
-    moves_bb = potential_moves & land_squares_mask & ~friendly_occupancy & ~own_den_mask;
-    return moves_bb;
-}
-
-U64 generate_rat_moves(
-    int piece_square_idx,
-    U64 friendly_occupancy, 
-    U64 own_den_mask,
-    U64 lake_squares_mask 
-) {
-    (void)lake_squares_mask; 
-
-    U64 moves_bb = 0ULL;
-    if (piece_square_idx < 0 || piece_square_idx >= NUM_SQUARES) return 0ULL;
-    U64 piece_bb = (1ULL << piece_square_idx);
-
-    U64 north_target_sq_bb = 0ULL;
-    U64 south_target_sq_bb = 0ULL;
-    U64 east_target_sq_bb = 0ULL;
-    U64 west_target_sq_bb = 0ULL;
-
-    if (!(piece_bb & RANK_9_MASK)) north_target_sq_bb = (piece_bb << BOARD_WIDTH);
-    if (!(piece_bb & RANK_1_MASK)) south_target_sq_bb = (piece_bb >> BOARD_WIDTH);
-    if (!(piece_bb & FILE_H_MASK)) east_target_sq_bb = (piece_bb << 1);
-    if (!(piece_bb & FILE_A_MASK)) west_target_sq_bb = (piece_bb >> 1);
-    
-    U64 potential_moves = north_target_sq_bb | south_target_sq_bb | east_target_sq_bb | west_target_sq_bb;
-    moves_bb = potential_moves & ~friendly_occupancy & ~own_den_mask;
-    return moves_bb;
-}
-
-U64 generate_lion_tiger_jump_moves(
-    int piece_square_idx,
-    Player moving_player, 
-    U64 friendly_occupancy, 
-    U64 all_rat_occupancy, 
-    U64 own_den_mask,
-    U64 lake_squares_mask) {
-
-    (void)moving_player; 
-
-    U64 jump_moves_bb = 0ULL;
-    if (piece_square_idx < 0 || piece_square_idx >= NUM_SQUARES) return 0ULL;
-
-    std::pair<int, int> cr = get_col_row(piece_square_idx);
-    int col = cr.first;
-    int row = cr.second;
-
-    if (get_bit(lake_squares_mask, piece_square_idx)) {
-        return 0ULL; 
-    }
-
-    // Vertical Jumps:
-    if (row == 2) { 
-        int target_row = 6; 
-        if (col == 1 || col == 2 || col == 4 || col == 5) { 
-            U64 path_mask = 0ULL;
-            set_bit(path_mask, get_square_index(col, 3)); 
-            set_bit(path_mask, get_square_index(col, 4)); 
-            set_bit(path_mask, get_square_index(col, 5)); 
-            
-            if ((path_mask & lake_squares_mask) == path_mask && 
-                (path_mask & all_rat_occupancy) == 0ULL) {    
-                int target_sq = get_square_index(col, target_row);
-                U64 target_bb = (1ULL << target_sq);
-                if (get_bit(LAND_SQUARES_MASK, target_sq) && 
-                    !(target_bb & friendly_occupancy) &&  
-                    !(target_bb & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq);
-                }
-            }
+namespace {
+
+// Landing squares of each piece of one side, with capture legality folded in as bitboards.
+// capturable[type]: the enemy squares a piece of that type may capture, so a target set is
+// simply steps & (empty | capturable). Rules folded in:
+//  - any enemy standing on one of our traps (next to our den) can be taken by anything;
+//  - otherwise the attacker's rank must be >= the defender's (types are ordered by rank),
+//    except that the rat takes the elephant and the elephant cannot take the rat;
+//  - a rat only captures between two land squares or two lake squares.
+struct MoveTargets {
+    U64 enemy_occupancy;
+    U64 empty_squares;
+    U64 allowed_targets; // Not friendly, not the own den
+    U64 all_rats_bb;
+    U64 capturable[NUM_PIECE_TYPES];
+    U64 rat_capturable_from_land;
+    U64 rat_capturable_from_lake;
+
+    MoveTargets(const BoardState& board_state, Player player_to_move, Player opponent) {
+        U64 friendly_occupancy = board_state.occupancy_bbs[player_to_move];
+        U64 own_den_mask = (player_to_move == PLAYER_1) ? P1_DEN_SQUARE_MASK : P2_DEN_SQUARE_MASK;
+        enemy_occupancy = board_state.occupancy_bbs[opponent];
+        empty_squares = ~(friendly_occupancy | enemy_occupancy);
+        allowed_targets = ~friendly_occupancy & ~own_den_mask;
+        all_rats_bb = board_state.piece_bb(RAT, PLAYER_1) | board_state.piece_bb(RAT, PLAYER_2);
+
+        U64 own_traps_mask = (player_to_move == PLAYER_1) ? TRAPS_NEAR_P1_DEN_MASK : TRAPS_NEAR_P2_DEN_MASK;
+        U64 trapped_enemies = enemy_occupancy & own_traps_mask;
+
+        capturable[NO_PIECE_TYPE] = 0ULL;
+        U64 enemy_up_to_rank = 0ULL;
+        for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
+            enemy_up_to_rank |= board_state.piece_bb(pt_idx, opponent);
+            capturable[pt_idx] = enemy_up_to_rank | trapped_enemies;
         }
+        capturable[RAT] |= board_state.piece_bb(ELEPHANT, opponent);
+        capturable[ELEPHANT] &= ~board_state.piece_bb(RAT, opponent) | trapped_enemies;
+        rat_capturable_from_land = capturable[RAT] & ~LAKE_SQUARES_MASK;
+        rat_capturable_from_lake = capturable[RAT] & LAKE_SQUARES_MASK;
     }
-    else if (row == 6) {
-        int target_row = 2; 
-        if (col == 1 || col == 2 || col == 4 || col == 5) { 
-            U64 path_mask = 0ULL;
-            set_bit(path_mask, get_square_index(col, 5)); 
-            set_bit(path_mask, get_square_index(col, 4)); 
-            set_bit(path_mask, get_square_index(col, 3)); 
 
-            if ((path_mask & lake_squares_mask) == path_mask &&
-                (path_mask & all_rat_occupancy) == 0ULL) {
-                int target_sq = get_square_index(col, target_row);
-                U64 target_bb = (1ULL << target_sq);
-                if (get_bit(LAND_SQUARES_MASK, target_sq) &&
-                    !(target_bb & friendly_occupancy) && 
-                    !(target_bb & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq);
-                }
+    // Table lookups: step targets per square, plus the open lion/tiger jumps,
+    // restricted to empty squares and enemies this piece may capture.
+    U64 targets(PieceType piece_type_moving, int from_sq) const {
+        U64 possible_landing_squares_bb;
+        if (piece_type_moving == RAT) {
+            possible_landing_squares_bb = AttackTables::RAT_STEP_TARGETS[from_sq] &
+                (empty_squares | (get_bit(LAKE_SQUARES_MASK, from_sq) ? rat_capturable_from_lake : rat_capturable_from_land));
+        } else {
+            possible_landing_squares_bb = AttackTables::LAND_STEP_TARGETS[from_sq];
+            if (piece_type_moving == LION || piece_type_moving == TIGER) {
+                possible_landing_squares_bb |= AttackTables::open_jump_targets(from_sq, all_rats_bb);
             }
+            possible_landing_squares_bb &= empty_squares | capturable[piece_type_moving];
         }
+        return possible_landing_squares_bb & allowed_targets;
     }
+};
 
-    // Horizontal Jumps:
-    if (col == 0) {
-        int target_col = 3;
-        if (row == 3 || row == 4 || row == 5) { 
-            U64 path_mask = 0ULL;
-            set_bit(path_mask, get_square_index(1, row)); 
-            set_bit(path_mask, get_square_index(2, row)); 
-            if ((path_mask & lake_squares_mask) == path_mask &&
-                (path_mask & all_rat_occupancy) == 0ULL) {
-                int target_sq = get_square_index(target_col, row);
-                U64 target_bb = (1ULL << target_sq);
-                if (get_bit(LAND_SQUARES_MASK, target_sq) &&
-                    !(target_bb & friendly_occupancy) && 
-                    !(target_bb & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq);
-                }
-            }
-        }
-    }
-    else if (col == 6) {
-        int target_col = 3;
-        if (row == 3 || row == 4 || row == 5) { 
-            U64 path_mask = 0ULL;
-            set_bit(path_mask, get_square_index(5, row)); 
-            set_bit(path_mask, get_square_index(4, row)); 
-            if ((path_mask & lake_squares_mask) == path_mask &&
-                (path_mask & all_rat_occupancy) == 0ULL) {
-                int target_sq = get_square_index(target_col, row);
-                U64 target_bb = (1ULL << target_sq);
-                if (get_bit(LAND_SQUARES_MASK, target_sq) &&
-                    !(target_bb & friendly_occupancy) && 
-                    !(target_bb & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq);
-                }
-            }
-        }
-    }
-    else if (col == 3) {
-        if (row == 3 || row == 4 || row == 5) { 
-            int target_col_west = 0;
-            U64 path_mask_west = 0ULL;
-            set_bit(path_mask_west, get_square_index(2, row)); 
-            set_bit(path_mask_west, get_square_index(1, row)); 
-            if ((path_mask_west & lake_squares_mask) == path_mask_west &&
-                (path_mask_west & all_rat_occupancy) == 0ULL) {
-                int target_sq_w = get_square_index(target_col_west, row);
-                U64 target_bb_w = (1ULL << target_sq_w);
-                if (get_bit(LAND_SQUARES_MASK, target_sq_w) &&
-                    !(target_bb_w & friendly_occupancy) && 
-                    !(target_bb_w & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq_w);
-                }
-            }
-
-            int target_col_east = 6;
-            U64 path_mask_east = 0ULL;
-            set_bit(path_mask_east, get_square_index(4, row)); 
-            set_bit(path_mask_east, get_square_index(5, row)); 
-            if ((path_mask_east & lake_squares_mask) == path_mask_east &&
-                (path_mask_east & all_rat_occupancy) == 0ULL) {
-                int target_sq_e = get_square_index(target_col_east, row);
-                U64 target_bb_e = (1ULL << target_sq_e);
-                 if (get_bit(LAND_SQUARES_MASK, target_sq_e) &&
-                    !(target_bb_e & friendly_occupancy) && 
-                    !(target_bb_e & own_den_mask)) {
-                    set_bit(jump_moves_bb, target_sq_e);
-                }
-            }
-        }
-    }
-    return jump_moves_bb;
-}
+} // namespace
 
 
-std::vector<Move> generate_all_legal_moves(
+void generate_all_legal_moves(
     const BoardState& board_state, 
     Player player_to_move,
-    const std::vector<BoardState>& game_history_for_rep_check // Pass the actual game history
+    const RepetitionStack& repetition_stack,
+    MoveList& legal_moves
 ) {
-    std::vector<Move> pseudo_legal_moves;
+    legal_moves.clear();
     if (player_to_move == NO_PLAYER) {
-        return pseudo_legal_moves; // Return empty list
+        return; // Leave the list empty
     }
 
-    U64 friendly_occupancy = board_state.occupancy_bbs[player_to_move];
-    U64 own_den_mask = (player_to_move == PLAYER_1) ? P1_DEN_SQUARE_MASK : P2_DEN_SQUARE_MASK;
+    // For the 3-fold repetition check the resulting hash is derived from the move
+    // instead of playing it on a copy of the board.
+    Player opponent = (player_to_move == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    U64 side_keys = Zobrist::side_to_move_key[board_state.side_to_move] ^ Zobrist::side_to_move_key[opponent];
+
+    MoveTargets move_targets(board_state, player_to_move, opponent);
 
     for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
         PieceType piece_type_moving = static_cast<PieceType>(pt_idx);
-        U64 piece_locations_bb = board_state.piece_bbs[piece_type_moving][player_to_move];
+        U64 piece_locations_bb = board_state.piece_bb(piece_type_moving, player_to_move);
         U64 temp_piece_locations_bb = piece_locations_bb;
 
         while (temp_piece_locations_bb > 0) {
             int from_sq = pop_lsb(temp_piece_locations_bb);
             if (from_sq == -1) break; 
 
-            U64 possible_landing_squares_bb = 0ULL;
-            // Piece attacker_piece_obj = Piece(piece_type_moving, player_to_move); // Not needed here
-
-            if (piece_type_moving == CAT || piece_type_moving == DOG || piece_type_moving == WOLF || 
-                piece_type_moving == PANTHER || piece_type_moving == ELEPHANT) {
-                possible_landing_squares_bb = generate_orthogonal_step_moves(
-                    from_sq, friendly_occupancy, LAND_SQUARES_MASK, own_den_mask);
-            } else if (piece_type_moving == RAT) {
-                possible_landing_squares_bb = generate_rat_moves(
-                    from_sq, friendly_occupancy, own_den_mask, LAKE_SQUARES_MASK);
-            } else if (piece_type_moving == LION || piece_type_moving == TIGER) {
-                possible_landing_squares_bb = generate_orthogonal_step_moves(
-                    from_sq, friendly_occupancy, LAND_SQUARES_MASK, own_den_mask);
-                U64 all_rats_bb = board_state.piece_bbs[RAT][PLAYER_1] | board_state.piece_bbs[RAT][PLAYER_2];
-                possible_landing_squares_bb |= generate_lion_tiger_jump_moves(
-                    from_sq, player_to_move, friendly_occupancy, all_rats_bb, own_den_mask, LAKE_SQUARES_MASK);
-            }
-
-            U64 temp_targets_bb = possible_landing_squares_bb;
+            U64 temp_targets_bb = move_targets.targets(piece_type_moving, from_sq);
             while (temp_targets_bb > 0) {
                 int to_sq = pop_lsb(temp_targets_bb);
                 if (to_sq == -1) break;
 
-                Piece defender_on_target = board_state.get_piece_at(to_sq);
-                PieceType captured_piece_type = NO_PIECE_TYPE;
-                bool is_capture_attempt = (defender_on_target.player != NO_PLAYER && defender_on_target.player != player_to_move);
-                bool move_is_board_legal = false;
+                // Friendly squares are already masked out, so whatever stands here is the victim.
+                PieceType captured_piece_type = board_state.piece_type_at(to_sq);
 
-                if (!is_capture_attempt) { // Moving to an empty square
-                    move_is_board_legal = true;
-                } else { // Attempting to capture an enemy piece
-                    bool can_capture_this_enemy = false;
-                    int attacker_rank = PIECE_RANKS[piece_type_moving]; // Attacker is piece_type_moving
-                    int defender_rank = PIECE_RANKS[defender_on_target.type];
+                // A capture leads to a position with fewer pieces than any before it: it can never repeat.
+                if (captured_piece_type == NO_PIECE_TYPE) {
+                    U64 next_hash = board_state.zobrist_hash ^ side_keys
+                                  ^ Zobrist::piece_keys[piece_type_moving][player_to_move][from_sq]
+                                  ^ Zobrist::piece_keys[piece_type_moving][player_to_move][to_sq];
 
-                    bool defender_is_weakened_by_trap = false;
-                    U64 traps_that_weaken_defender = (defender_on_target.player == PLAYER_1) ? TRAPS_NEAR_P2_DEN_MASK : TRAPS_NEAR_P1_DEN_MASK;
-                    if (get_bit(traps_that_weaken_defender, to_sq)) {
-                        defender_is_weakened_by_trap = true;
-                    }
-                    
-                    if (defender_is_weakened_by_trap) {
-                        can_capture_this_enemy = true; 
-                    } else {
-                        if (attacker_rank >= defender_rank) can_capture_this_enemy = true;
-                        if (piece_type_moving == RAT && defender_on_target.type == ELEPHANT) can_capture_this_enemy = true;
-                        if (piece_type_moving == ELEPHANT && defender_on_target.type == RAT) can_capture_this_enemy = false; 
-                    }
-                    
-                    if (piece_type_moving == RAT && can_capture_this_enemy) {
-                        bool attacker_on_water = get_bit(LAKE_SQUARES_MASK, from_sq);
-                        bool defender_on_water = get_bit(LAKE_SQUARES_MASK, to_sq);
-                        if (attacker_on_water != defender_on_water) {
-                            can_capture_this_enemy = false; 
-                        }
-                    }
-                    if (can_capture_this_enemy) {
-                        move_is_board_legal = true;
-                        captured_piece_type = defender_on_target.type;
-                    }
-                } 
-                if (move_is_board_legal) {
-                    pseudo_legal_moves.push_back(Move(from_sq, to_sq, piece_type_moving, captured_piece_type));
+                    // According to Arimaa rules (and common chess), making a move that results in the
+                    // position appearing for the third time is illegal.
+                    // So, if the hash has appeared twice *before* this move, this move is illegal.
+                    // (The hash includes the side to move, so only same-side positions can match.)
+                    if (repetition_stack.count(next_hash) >= 2) continue;
                 }
+                legal_moves.push_back(Move(from_sq, to_sq, piece_type_moving, captured_piece_type));
             } 
         } 
     } 
+}
+
+void generate_tactical_moves(
+    const BoardState& board_state,
+    Player player_to_move,
+    bool include_trap_moves,
+    MoveList& tactical_moves
+) {
+    tactical_moves.clear();
+    if (player_to_move == NO_PLAYER) {
+        return;
+    }
+
+    Player opponent = (player_to_move == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    MoveTargets move_targets(board_state, player_to_move, opponent);
 
-    // Now, filter pseudo_legal_moves for 3-fold repetition
-    std::vector<Move> truly_legal_moves;
-    truly_legal_moves.reserve(pseudo_legal_moves.size());
+    // Quiet moves that still count: into the enemy den (wins) and, optionally, onto the traps
+    // around it (threatens to win next move).
+    U64 enemy_den_mask = (player_to_move == PLAYER_1) ? P2_DEN_SQUARE_MASK : P1_DEN_SQUARE_MASK;
+    U64 enemy_traps_mask = (player_to_move == PLAYER_1) ? TRAPS_NEAR_P2_DEN_MASK : TRAPS_NEAR_P1_DEN_MASK;
+    U64 tactical_squares = move_targets.enemy_occupancy | enemy_den_mask;
+    if (include_trap_moves) {
+        tactical_squares |= enemy_traps_mask;
+    }
 
-    for (const Move& move : pseudo_legal_moves) {
-        BoardState next_state_after_move = board_state; // Create a copy to simulate the move
-        next_state_after_move.apply_move(move);      // This updates next_state_after_move.zobrist_hash
+    for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
+        PieceType piece_type_moving = static_cast<PieceType>(pt_idx);
+        U64 temp_piece_locations_bb = board_state.piece_bb(piece_type_moving, player_to_move);
 
-        int repetition_count = 0;
-        // Count occurrences of the resulting hash in the actual game history
-        // The game_history_for_rep_check should contain states *before* the current one.
-        for (const BoardState& historical_state : game_history_for_rep_check) {
-            if (historical_state.zobrist_hash == next_state_after_move.zobrist_hash &&
-                historical_state.side_to_move == next_state_after_move.side_to_move) { // Ensure side to move also matches for true repetition
-                repetition_count++;
+        while (temp_piece_locations_bb > 0) {
+            int from_sq = pop_lsb(temp_piece_locations_bb);
+            U64 temp_targets_bb = move_targets.targets(piece_type_moving, from_sq) & tactical_squares;
+            while (temp_targets_bb > 0) {
+                int to_sq = pop_lsb(temp_targets_bb);
+                tactical_moves.push_back(Move(from_sq, to_sq, piece_type_moving, board_state.piece_type_at(to_sq)));
             }
         }
-        // According to Arimaa rules (and common chess), making a move that results in the
-        // position appearing for the third time is illegal.
-        // So, if the hash has appeared twice *before* this move, this move is illegal.
-        if (repetition_count < 2) { 
-            truly_legal_moves.push_back(move);
-        } else {
-            // std::cout << "Repetition Detected: Move " << move.to_string() 
-            //           << " would lead to 3rd occurrence of hash 0x" << std::hex 
-            //           << next_state_after_move.zobrist_hash << std::dec << std::endl;
-        }
     }
-    return truly_legal_moves;
 }
 
+U64 den_entry_threats(const BoardState& board_state, Player defender) {
+    if (defender == NO_PLAYER) return 0ULL;
+    Player opponent = (defender == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    U64 own_traps_mask = (defender == PLAYER_1) ? TRAPS_NEAR_P1_DEN_MASK : TRAPS_NEAR_P2_DEN_MASK;
+    return board_state.occupancy_bbs[opponent] & own_traps_mask;
+}
 
+U64 attacked_trap_occupants(const BoardState& board_state, Player attacker) {
+    U64 trapped_enemies = den_entry_threats(board_state, attacker);
+    U64 attackers = board_state.occupancy_bbs[attacker];
+    U64 attacked = 0ULL;
+    while (trapped_enemies) {
+        int sq = pop_lsb(trapped_enemies);
+        // Traps are land squares away from the lake and the jump lanes, so only plain land steps
+        // reach them; on a trap the piece has no rank, so any attacker one step away may capture.
+        if (AttackTables::LAND_STEP_TARGETS[sq] & attackers) {
+            set_bit(attacked, sq);
+        }
+    }
+    return attacked;
+}
@@ -4,7 +4,8 @@
 
 #include "bitboard.h" // For U64, board constants, and square_to_algebraic (used in Move::to_string)
 #include "piece.h"    // For Player enum, PieceType, PIECE_CHARS, BoardState (for generate_all_legal_moves)
-#include <vector>     // For std::vector<Move>
+#include "repetition.h" // For RepetitionStack (3-fold repetition filtering)
+#include <array>      // For MoveList storage
 #include <string>     // For std::string in Move::to_string
 
 // Represents a single game move
@@ -22,6 +23,12 @@ struct Move {
                piece_moved == other.piece_moved && piece_captured == other.piece_captured;
     }
 
+    // Same from/to squares. A move stored in the transposition table does not record the
+    // captured piece, so it is matched against the legal moves of the position this way.
+    bool same_squares(const Move& other) const {
+        return from_sq == other.from_sq && to_sq == other.to_sq;
+    }
+
     std::string to_string() const {
         std::string s = "";
         if (from_sq != -1 && to_sq != -1) {
@@ -41,53 +48,66 @@ struct Move {
 };
 
 
-// Generates one-step orthogonal moves for a piece.
-// Landing square can be empty or occupied by an enemy (capture).
-// Piece cannot move onto a square occupied by a friendly piece.
-// Piece cannot move into its own den.
-// Piece must land on a land square.
-U64 generate_orthogonal_step_moves(
-    int piece_square_idx, 
-    U64 friendly_occupancy, 
-    U64 land_squares_mask,
-    U64 own_den_mask
-);
+// Upper bound on the moves of one side: at most 8 pieces with 4 targets each
+// (a lion/tiger trades blocked lake steps for jumps), plus generous headroom.
+const int MAX_MOVES = 64;
 
-// Generates moves for a Rat.
-// Rat can move to adjacent land or water squares.
-// Landing square can be empty or occupied by an enemy (capture).
-// Cannot move to a square occupied by a friendly piece.
-// Cannot move into its own den.
-U64 generate_rat_moves(
-    int piece_square_idx,
-    U64 friendly_occupancy, 
-    U64 own_den_mask,
-    U64 lake_squares_mask   
-);
+// Fixed-capacity move list that lives on the stack, so move generation in the
+// search never touches the heap. Supports the subset of std::vector used here.
+struct MoveList {
+    std::array<Move, MAX_MOVES> moves;
+    int count;
+
+    MoveList() : count(0) {}
+
+    void push_back(const Move& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves.data(); }
+    Move* end() { return moves.data() + count; }
+    const Move* begin() const { return moves.data(); }
+    const Move* end() const { return moves.data() + count; }
+};
 
-// Generates JUMP moves for Lion or Tiger.
-// Can jump over a river (straight jumps over 2 or 3 river squares).
-// Landing square can be empty or occupied by an enemy (capture).
-// Cannot jump if a rat (any player's rat) is in the intervening river squares.
-// Cannot jump to a square occupied by a friendly piece.
-// Cannot jump into its own den.
-U64 generate_lion_tiger_jump_moves(
-    int piece_square_idx,
-    Player moving_player,   
-    U64 friendly_occupancy, 
-    U64 all_rat_occupancy,  
-    U64 own_den_mask,
-    U64 lake_squares_mask   
-);
 
 // Generates all legal moves for the given player from the current board state,
-// including checks for 3-fold repetition.
-std::vector<Move> generate_all_legal_moves(
-    const BoardState& board_state,          // Current state to generate moves from
-    Player player_to_move,                  // Player whose moves are being generated
-    const std::vector<BoardState>& game_history // Full game history to check for repetitions
+// including checks for 3-fold repetition. Fills 'legal_moves' in place (it is cleared first).
+// 'repetition_stack' must hold every position reached so far, ending with 'board_state' itself.
+void generate_all_legal_moves(
+    const BoardState& board_state,           // Current state to generate moves from
+    Player player_to_move,                   // Player whose moves are being generated
+    const RepetitionStack& repetition_stack, // Positions reached so far, to check for repetitions
+    MoveList& legal_moves                    // Output list
+);
+
+// Generates the tactical moves for quiescence search: captures, moves into the enemy den and,
+// with 'include_trap_moves', moves onto the traps next to the enemy den. Fills 'tactical_moves'
+// in place. No repetition check: captures and den entries can never repeat a position, so only
+// trap moves may need one (see quiescence_search in ai.cpp).
+void generate_tactical_moves(
+    const BoardState& board_state,
+    Player player_to_move,
+    bool include_trap_moves,
+    MoveList& tactical_moves
 );
 
+// --- Threat detectors (bitboard only, no move generation) ---
+// Every square next to a den is a trap of its owner, so a piece on one of the defender's traps
+// steps into the den next move unless it is captured first; and since any piece standing on an
+// enemy trap can be captured by anything, the threat can only be parried by stepping onto it.
+
+// Pieces of the defender's opponent that can enter 'defender's den on their next move.
+U64 den_entry_threats(const BoardState& board_state, Player defender);
+
+// Enemy pieces on 'attacker's traps that 'attacker' can capture on its next move
+// (some piece of 'attacker' stands one step away).
+U64 attacked_trap_occupants(const BoardState& board_state, Player attacker);
+
 
 #endif // MOVEGEN_H
 
@@ -0,0 +1,71 @@
+// bbdsq/packed_position.cpp
+#include "packed_position.h"
+#include "zobrist.h" // For the keys hash() combines
+#include <cstring>   // For std::memcmp
+
+PackedPosition::PackedPosition() : side_to_move(static_cast<uint8_t>(PLAYER_1)) {
+    for (int p = 0; p < 2; ++p) {
+        for (int i = 0; i < NUM_PIECE_TYPES - 1; ++i) {
+            squares[p][i] = NO_SQUARE;
+        }
+    }
+}
+
+PackedPosition PackedPosition::from_board(const BoardState& board_state) {
+    PackedPosition packed;
+    for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+        for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+            U64 bb = board_state.piece_bb(pt, p);
+            packed.squares[p - 1][pt - 1] = (bb != 0ULL) ? static_cast<uint8_t>(lsb_index(bb)) : NO_SQUARE;
+        }
+    }
+    packed.side_to_move = static_cast<uint8_t>(board_state.side_to_move);
+    return packed;
+}
+
+BoardState PackedPosition::to_board() const {
+    BoardState board_state;
+    for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+        for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+            uint8_t sq = square_of(pt, p);
+            if (sq < NUM_SQUARES) {
+                set_bit(board_state.piece_bb(pt, p), sq);
+            }
+        }
+    }
+    board_state.side_to_move = static_cast<Player>(side_to_move);
+    board_state.update_occupancy_boards();
+    board_state.force_recalculate_hash();
+    board_state.force_recalculate_material_pst();
+    return board_state;
+}
+
+U64 PackedPosition::hash() const {
+    U64 key = 0ULL;
+    for (int p = PLAYER_1; p <= PLAYER_2; ++p) {
+        for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+            uint8_t sq = square_of(pt, p);
+            if (sq < NUM_SQUARES) {
+                key ^= Zobrist::piece_keys[pt][p][sq];
+            }
+        }
+    }
+    if (side_to_move != NO_PLAYER) {
+        key ^= Zobrist::side_to_move_key[side_to_move];
+    }
+    return key;
+}
+
+int PackedPosition::piece_count() const {
+    int count = 0;
+    for (int p = 0; p < 2; ++p) {
+        for (int i = 0; i < NUM_PIECE_TYPES - 1; ++i) {
+            if (squares[p][i] != NO_SQUARE) count++;
+        }
+    }
+    return count;
+}
+
+bool PackedPosition::operator==(const PackedPosition& other) const {
+    return std::memcmp(squares, other.squares, sizeof(squares)) == 0 && side_to_move == other.side_to_move;
+}
@@ -0,0 +1,42 @@
+// bbdsq/packed_position.h
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+
+#include "bitboard.h" // For U64, NUM_SQUARES
+#include "piece.h"    // For BoardState, PieceType, Player
+#include <cstdint>
+
+// Compact encoding of a position. Each side owns at most one piece of each of the eight types,
+// so a position is fully described by 16 square bytes plus the side to move: 17 bytes against
+// the 256 of a BoardState. Used for the game history, for rebuilding the repetition stack and
+// in the save file; a natural key for any future opening book or endgame table as well.
+struct PackedPosition {
+    static const uint8_t NO_SQUARE = 0xFF; // The piece has been captured
+
+    uint8_t squares[2][NUM_PIECE_TYPES - 1]; // [Player - 1][PieceType - 1]: square 0-62 or NO_SQUARE
+    uint8_t side_to_move;                   // Player value, NO_PLAYER once the game is over
+
+    // An empty board, PLAYER_1 to move.
+    PackedPosition();
+
+    // Takes the lowest set square of each piece bitboard (there is never more than one).
+    static PackedPosition from_board(const BoardState& board_state);
+    // Full BoardState with occupancy, mailbox, Zobrist hash and material + PST score rebuilt.
+    BoardState to_board() const;
+
+    uint8_t square_of(int pt, int p) const { return squares[p - 1][pt - 1]; }
+
+    // Zobrist key of the position, equal to to_board().zobrist_hash but computed straight from
+    // the 16 squares (no BoardState is built).
+    U64 hash() const;
+
+    // Pieces still on the board. Counts only ever go down, so a drop between two history
+    // entries marks a capture.
+    int piece_count() const;
+
+    bool operator==(const PackedPosition& other) const;
+    bool operator!=(const PackedPosition& other) const { return !(*this == other); }
+};
+static_assert(sizeof(PackedPosition) == 17, "PackedPosition must stay 16 squares + side");
+
+#endif // PACKED_POSITION_H
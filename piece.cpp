@@ -2,24 +2,28 @@
 #include "piece.h"
 #include "zobrist.h" // For Zobrist keys and hash calculation/update functions
 #include "movegen.h" // For the Move struct definition (used by apply_move)
+#include "pst.h"     // For PIECE_SQUARE_VALUES (running material + PST score)
 #include <stdexcept> 
 #include <iostream>  
 
 // --- BoardState Member Function Definitions ---
 
 BoardState::BoardState() : 
-    side_to_move(PLAYER_1), 
-    zobrist_hash(0ULL) // Initial hash is 0, will be properly set by setup or load
+    zobrist_hash(0ULL), // Initial hash is 0, will be properly set by setup or load
+    side_to_move(PLAYER_1)
 {
     // Initialize all bitboards to empty
-    for (int pt = 0; pt < NUM_PIECE_TYPES; ++pt) {
-        piece_bbs[pt][NO_PLAYER] = 0ULL; // Should always be 0
-        piece_bbs[pt][PLAYER_1] = 0ULL;
-        piece_bbs[pt][PLAYER_2] = 0ULL;
+    for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+        piece_bb(pt, PLAYER_1) = 0ULL;
+        piece_bb(pt, PLAYER_2) = 0ULL;
     }
     // Initialize occupancy bitboards to empty
     for (int p = 0; p < 3; ++p) { // Iterate NO_PLAYER, PLAYER_1, PLAYER_2
         occupancy_bbs[p] = 0ULL;
+        material_pst[p] = 0;
+    }
+    for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+        mailbox[sq] = 0;
     }
     // Note: A full hash calculation will be done by setup_initial_board()
     // or when a game is loaded.
@@ -30,6 +34,21 @@ void BoardState::force_recalculate_hash() {
     this->zobrist_hash = Zobrist::calculate_initial_hash(*this);
 }
 
+void BoardState::force_recalculate_material_pst() {
+    for (int p_val = 0; p_val < 3; ++p_val) {
+        material_pst[p_val] = 0;
+    }
+    for (int p_val = PLAYER_1; p_val <= PLAYER_2; ++p_val) {
+        for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
+            U64 bb = piece_bb(pt_idx, p_val);
+            while (bb) {
+                int sq = pop_lsb(bb);
+                material_pst[p_val] += PIECE_SQUARE_VALUES[pt_idx][p_val][sq];
+            }
+        }
+    }
+}
+
 // Low-level function, primarily for setup_initial_board.
 // Assumes square is currently empty by this player for this piece type.
 void BoardState::add_piece(int sq, PieceType pt, Player p) {
@@ -38,8 +57,10 @@ void BoardState::add_piece(int sq, PieceType pt, Player p) {
         return;
     }
     // Check if piece already exists to prevent double XORing if called incorrectly
-    if (!get_bit(this->piece_bbs[pt][p], sq)) { 
-        set_bit(this->piece_bbs[pt][p], sq);
+    if (!get_bit(this->piece_bb(pt, p), sq)) { 
+        set_bit(this->piece_bb(pt, p), sq);
+        this->mailbox[sq] = mailbox_code(pt, p);
+        this->material_pst[p] += PIECE_SQUARE_VALUES[pt][p][sq];
         Zobrist::xor_piece_at_sq(this->zobrist_hash, pt, p, sq); // Update hash
     } else {
         // std::cerr << "Warning (add_piece): Piece already exists at " << square_to_algebraic(sq) << std::endl;
@@ -55,8 +76,10 @@ void BoardState::remove_piece(int sq, PieceType pt, Player p) {
         return;
     }
     // Check if piece actually exists to prevent XORing if called incorrectly
-    if (get_bit(this->piece_bbs[pt][p], sq)) { 
-        clear_bit(this->piece_bbs[pt][p], sq);
+    if (get_bit(this->piece_bb(pt, p), sq)) { 
+        clear_bit(this->piece_bb(pt, p), sq);
+        this->mailbox[sq] = 0;
+        this->material_pst[p] -= PIECE_SQUARE_VALUES[pt][p][sq];
         Zobrist::xor_piece_at_sq(this->zobrist_hash, pt, p, sq); // Update hash
     } else {
         // std::cerr << "Warning (remove_piece): No such piece to remove at " << square_to_algebraic(sq) << std::endl;
@@ -74,7 +97,7 @@ void BoardState::apply_move(const Move& move) {
     Player player_making_move = this->side_to_move; 
 
     // Sanity check: piece being moved should exist at from_sq and belong to player_making_move
-    if (!get_bit(this->piece_bbs[move.piece_moved][player_making_move], move.from_sq)) {
+    if (!get_bit(this->piece_bb(move.piece_moved, player_making_move), move.from_sq)) {
         std::cerr << "Error (apply_move): Piece " << PIECE_CHARS[move.piece_moved] 
                   << " for player " << player_making_move 
                   << " not found at source square " << square_to_algebraic(move.from_sq) << std::endl;
@@ -85,15 +108,19 @@ void BoardState::apply_move(const Move& move) {
     // 1. Update hash: XOR out the piece from its original square
     Zobrist::xor_piece_at_sq(this->zobrist_hash, move.piece_moved, player_making_move, move.from_sq);
     // Update bitboard: Clear piece from original square
-    clear_bit(this->piece_bbs[move.piece_moved][player_making_move], move.from_sq);
+    clear_bit(this->piece_bb(move.piece_moved, player_making_move), move.from_sq);
+    clear_bit(this->occupancy_bbs[player_making_move], move.from_sq);
+    this->mailbox[move.from_sq] = 0;
 
     // 2. If it was a capture, update hash and bitboard for the captured piece
     if (move.piece_captured != NO_PIECE_TYPE) {
         Player opponent = (player_making_move == PLAYER_1) ? PLAYER_2 : PLAYER_1;
         // Sanity check: ensure the captured piece is indeed on the target square and belongs to opponent
-        if (get_bit(this->piece_bbs[move.piece_captured][opponent], move.to_sq)) {
+        if (get_bit(this->piece_bb(move.piece_captured, opponent), move.to_sq)) {
             Zobrist::xor_piece_at_sq(this->zobrist_hash, move.piece_captured, opponent, move.to_sq);
-            clear_bit(this->piece_bbs[move.piece_captured][opponent], move.to_sq);
+            clear_bit(this->piece_bb(move.piece_captured, opponent), move.to_sq);
+            clear_bit(this->occupancy_bbs[opponent], move.to_sq);
+            this->material_pst[opponent] -= PIECE_SQUARE_VALUES[move.piece_captured][opponent][move.to_sq];
         } else {
             std::cerr << "Warning (apply_move): Move object indicated capture of "
                       << PIECE_CHARS[move.piece_captured] << " (Player " << opponent << ") at " 
@@ -108,7 +135,12 @@ void BoardState::apply_move(const Move& move) {
     // 3. Update hash: XOR in the piece at its new square
     Zobrist::xor_piece_at_sq(this->zobrist_hash, move.piece_moved, player_making_move, move.to_sq);
     // Update bitboard: Set piece at new square
-    set_bit(this->piece_bbs[move.piece_moved][player_making_move], move.to_sq);
+    set_bit(this->piece_bb(move.piece_moved, player_making_move), move.to_sq);
+    set_bit(this->occupancy_bbs[player_making_move], move.to_sq);
+    this->occupancy_bbs[NO_PLAYER] = this->occupancy_bbs[PLAYER_1] | this->occupancy_bbs[PLAYER_2];
+    this->mailbox[move.to_sq] = mailbox_code(move.piece_moved, player_making_move);
+    this->material_pst[player_making_move] += PIECE_SQUARE_VALUES[move.piece_moved][player_making_move][move.to_sq]
+                                            - PIECE_SQUARE_VALUES[move.piece_moved][player_making_move][move.from_sq];
 
     // 4. Update hash: XOR out old side_to_move key, XOR in new side_to_move key
     if (this->side_to_move != NO_PLAYER) { 
@@ -118,44 +150,117 @@ void BoardState::apply_move(const Move& move) {
     if (this->side_to_move != NO_PLAYER) { 
         Zobrist::xor_side_to_move(this->zobrist_hash, this->side_to_move);
     }
-    
-    this->update_occupancy_boards(); 
 }
 
+void BoardState::make_move(const Move& move, UndoInfo& undo) {
+    Player us = this->side_to_move;
+    Player them = (us == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    U64 from_bb = 1ULL << move.from_sq;
+    U64 to_bb = 1ULL << move.to_sq;
 
-Piece BoardState::get_piece_at(int sq) const {
-    if (sq < 0 || sq >= NUM_SQUARES) {
-        return Piece(NO_PIECE_TYPE, NO_PLAYER); 
-    }
-    for (int p_val = PLAYER_1; p_val <= PLAYER_2; ++p_val) { 
-        Player player = static_cast<Player>(p_val);
-        for (int pt_val = RAT; pt_val < NUM_PIECE_TYPES; ++pt_val) { 
-            PieceType pt = static_cast<PieceType>(pt_val);
-            if (get_bit(piece_bbs[pt][player], sq)) {
-                return Piece(pt, player);
-            }
-        }
+    undo.captured = move.piece_captured;
+    undo.previous_hash = this->zobrist_hash;
+    undo.previous_side = us;
+
+    if (move.piece_captured != NO_PIECE_TYPE) {
+        this->piece_bb(move.piece_captured, them) ^= to_bb;
+        this->occupancy_bbs[them] ^= to_bb;
+        this->zobrist_hash ^= Zobrist::piece_keys[move.piece_captured][them][move.to_sq];
+        this->material_pst[them] -= PIECE_SQUARE_VALUES[move.piece_captured][them][move.to_sq];
     }
-    return Piece(NO_PIECE_TYPE, NO_PLAYER);
+
+    this->piece_bb(move.piece_moved, us) ^= from_bb | to_bb;
+    this->occupancy_bbs[us] ^= from_bb | to_bb;
+    this->occupancy_bbs[NO_PLAYER] = this->occupancy_bbs[PLAYER_1] | this->occupancy_bbs[PLAYER_2];
+    this->mailbox[move.to_sq] = this->mailbox[move.from_sq];
+    this->mailbox[move.from_sq] = 0;
+    this->material_pst[us] += PIECE_SQUARE_VALUES[move.piece_moved][us][move.to_sq]
+                            - PIECE_SQUARE_VALUES[move.piece_moved][us][move.from_sq];
+
+    this->zobrist_hash ^= Zobrist::piece_keys[move.piece_moved][us][move.from_sq]
+                        ^ Zobrist::piece_keys[move.piece_moved][us][move.to_sq]
+                        ^ Zobrist::side_to_move_key[us]
+                        ^ Zobrist::side_to_move_key[them];
+    this->side_to_move = them;
 }
-    
+
+void BoardState::unmake_move(const Move& move, const UndoInfo& undo) {
+    Player us = undo.previous_side;
+    Player them = (us == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+    U64 from_bb = 1ULL << move.from_sq;
+    U64 to_bb = 1ULL << move.to_sq;
+
+    this->piece_bb(move.piece_moved, us) ^= from_bb | to_bb;
+    this->occupancy_bbs[us] ^= from_bb | to_bb;
+
+    this->mailbox[move.from_sq] = this->mailbox[move.to_sq];
+    this->mailbox[move.to_sq] = 0;
+    this->material_pst[us] += PIECE_SQUARE_VALUES[move.piece_moved][us][move.from_sq]
+                            - PIECE_SQUARE_VALUES[move.piece_moved][us][move.to_sq];
+
+    if (undo.captured != NO_PIECE_TYPE) {
+        this->piece_bb(undo.captured, them) ^= to_bb;
+        this->occupancy_bbs[them] ^= to_bb;
+        this->mailbox[move.to_sq] = mailbox_code(undo.captured, them);
+        this->material_pst[them] += PIECE_SQUARE_VALUES[undo.captured][them][move.to_sq];
+    }
+    this->occupancy_bbs[NO_PLAYER] = this->occupancy_bbs[PLAYER_1] | this->occupancy_bbs[PLAYER_2];
+
+    this->zobrist_hash = undo.previous_hash;
+    this->side_to_move = us;
+}
+
+void BoardState::make_null_move(UndoInfo& undo) {
+    Player us = this->side_to_move;
+    Player them = (us == PLAYER_1) ? PLAYER_2 : PLAYER_1;
+
+    undo.captured = NO_PIECE_TYPE;
+    undo.previous_hash = this->zobrist_hash;
+    undo.previous_side = us;
+
+    this->zobrist_hash ^= Zobrist::side_to_move_key[us] ^ Zobrist::side_to_move_key[them];
+    this->side_to_move = them;
+}
+
+void BoardState::unmake_null_move(const UndoInfo& undo) {
+    this->zobrist_hash = undo.previous_hash;
+    this->side_to_move = undo.previous_side;
+}
+
+
 void BoardState::update_occupancy_boards() {
     occupancy_bbs[PLAYER_1] = 0ULL;
     occupancy_bbs[PLAYER_2] = 0ULL;
     for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) { 
-        occupancy_bbs[PLAYER_1] |= piece_bbs[pt_idx][PLAYER_1];
-        occupancy_bbs[PLAYER_2] |= piece_bbs[pt_idx][PLAYER_2];
+        occupancy_bbs[PLAYER_1] |= piece_bb(pt_idx, PLAYER_1);
+        occupancy_bbs[PLAYER_2] |= piece_bb(pt_idx, PLAYER_2);
     }
     occupancy_bbs[NO_PLAYER] = occupancy_bbs[PLAYER_1] | occupancy_bbs[PLAYER_2];
+
+    // Rebuild the mailbox from the bitboards (they are the authority when written directly)
+    for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+        mailbox[sq] = 0;
+    }
+    for (int p_val = PLAYER_1; p_val <= PLAYER_2; ++p_val) {
+        for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
+            U64 bb = piece_bb(pt_idx, p_val);
+            while (bb) {
+                int sq = pop_lsb(bb);
+                mailbox[sq] = mailbox_code(static_cast<PieceType>(pt_idx), static_cast<Player>(p_val));
+            }
+        }
+    }
 }
 
 void BoardState::setup_initial_board() {
-    for (int pt_idx = 0; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
-        piece_bbs[pt_idx][PLAYER_1] = 0ULL;
-        piece_bbs[pt_idx][PLAYER_2] = 0ULL;
-        piece_bbs[pt_idx][NO_PLAYER] = 0ULL;
+    for (int pt_idx = RAT; pt_idx < NUM_PIECE_TYPES; ++pt_idx) {
+        piece_bb(pt_idx, PLAYER_1) = 0ULL;
+        piece_bb(pt_idx, PLAYER_2) = 0ULL;
     }
     zobrist_hash = 0ULL; // Reset hash before adding pieces
+    for (int p_val = 0; p_val < 3; ++p_val) {
+        material_pst[p_val] = 0; // Accumulated again by add_piece
+    }
 
     // Player 1 (Computer, Top)
     add_piece(get_square_index(0, 8), LION, PLAYER_1);     
@@ -83,15 +83,39 @@ struct Piece {
     }
 };
 
-// Structure to hold the state of all pieces on the board using bitboards
-struct BoardState {
-    U64 piece_bbs[NUM_PIECE_TYPES][3]; // [PieceType][Player: 0=NO_PLAYER, 1=P1, 2=P2]
+// Everything make_move() overwrites that unmake_move() cannot rebuild from the Move itself.
+// Kept deliberately small so the search can hold one per ply on the stack.
+struct UndoInfo {
+    PieceType captured;     // Piece type removed from the target square (NO_PIECE_TYPE if none)
+    U64 previous_hash;      // Zobrist hash before the move
+    Player previous_side;   // side_to_move before the move
+
+    UndoInfo() : captured(NO_PIECE_TYPE), previous_hash(0ULL), previous_side(NO_PLAYER) {}
+};
+
+// Structure to hold the state of all pieces on the board using bitboards.
+// Packed for cheap copies (game history, one per search thread, root move ordering): only the
+// 16 bitboards that can hold a piece are stored, and the struct starts on a cache line so a
+// copy touches the fewest lines. Use piece_bb() to reach a piece bitboard.
+struct alignas(64) BoardState {
+    U64 pieces[2][NUM_PIECE_TYPES - 1]; // [Player - 1][PieceType - 1], see piece_bb()
     U64 occupancy_bbs[3];             // [Player: 0=AllOccupancy, 1=P1, 2=P2]
-    Player side_to_move;
     U64 zobrist_hash;                 // <<<< NEW: Current Zobrist hash of this state
+    Player side_to_move;
+    // Running material + PST score per player ([0] unused): the sum of PIECE_SQUARE_VALUES (pst.h)
+    // over that player's pieces. Updated with one or two adds per move, so evaluation reads it directly.
+    int material_pst[3];
+    // Mailbox: one byte per square, (player << 4) | piece type, 0 for an empty square.
+    // Kept in sync with the bitboards by every function that moves pieces, so asking what stands
+    // on a square is a single load instead of a scan over all bitboards.
+    uint8_t mailbox[NUM_SQUARES];
 
     BoardState(); 
 
+    // Bitboard of one side's pieces of one type. pt must be RAT..ELEPHANT, p PLAYER_1 or PLAYER_2.
+    U64& piece_bb(int pt, int p) { return pieces[p - 1][pt - 1]; }
+    U64 piece_bb(int pt, int p) const { return pieces[p - 1][pt - 1]; }
+
     // Low-level bitboard manipulation, should update hash incrementally
     void add_piece(int sq, PieceType pt, Player p);    
     void remove_piece(int sq, PieceType pt, Player p); 
@@ -100,8 +124,32 @@ struct BoardState {
     // side_to_move update, and Zobrist hash update.
     void apply_move(const Move& move); // <<<< NEW/REPLACES old move_piece
 
-    Piece get_piece_at(int sq) const;
-    // Updates occupancy_bbs based on piece_bbs. 
+    // Fast in-place move for the search. No sanity checks: the move must come from the move generator
+    // for this exact position. Occupancy and hash are updated incrementally; 'undo' receives what
+    // unmake_move() needs to restore the previous state exactly.
+    void make_move(const Move& move, UndoInfo& undo);
+    void unmake_move(const Move& move, const UndoInfo& undo);
+
+    // Null move for the search (null-move pruning): the side to move passes. Only side_to_move
+    // and its Zobrist key change; unmake_null_move() restores them from 'undo'.
+    void make_null_move(UndoInfo& undo);
+    void unmake_null_move(const UndoInfo& undo);
+
+    Piece get_piece_at(int sq) const {
+        if (sq < 0 || sq >= NUM_SQUARES) {
+            return Piece(NO_PIECE_TYPE, NO_PLAYER); 
+        }
+        return Piece(static_cast<PieceType>(mailbox[sq] & 0x0F), static_cast<Player>(mailbox[sq] >> 4));
+    }
+    // Piece type on a square (NO_PIECE_TYPE if empty). No bounds check: sq must be 0-62.
+    PieceType piece_type_at(int sq) const {
+        return static_cast<PieceType>(mailbox[sq] & 0x0F);
+    }
+    static uint8_t mailbox_code(PieceType pt, Player p) {
+        return static_cast<uint8_t>((static_cast<int>(p) << 4) | static_cast<int>(pt));
+    }
+    // Updates occupancy_bbs and the mailbox based on the piece bitboards. Call after writing
+    // piece_bb() directly (e.g. when loading a game).
     // Does NOT change zobrist_hash by itself (hash changes with piece moves/side change).
     void update_occupancy_boards(); 
     
@@ -109,7 +157,11 @@ struct BoardState {
     void setup_initial_board(); 
     // Utility to recalculate the hash from scratch (e.g., for debugging or after complex state changes)
     void force_recalculate_hash(); // <<<< NEW
+    // Recalculates material_pst from the piece bitboards. Call after writing piece_bb() directly.
+    void force_recalculate_material_pst();
 };
+// 16 + 3 bitboards, hash, side, scores and mailbox: 239 bytes, padded to four cache lines.
+static_assert(sizeof(BoardState) == 256, "BoardState layout grew; keep it packed");
 
 // Utility function (defined in piece.cpp)
 // Converts square index (0-62) to algebraic notation (e.g., "a1", "g9")
@@ -149,3 +149,23 @@ const int PST_ELEPHANT_P2[NUM_SQUARES] = {
 };
 
 
+// --- Combined material + PST table ---
+
+int PIECE_SQUARE_VALUES[NUM_PIECE_TYPES][3][NUM_SQUARES] = {};
+
+void init_psts() {
+    // Per-piece tables in PieceType order, RAT..ELEPHANT
+    const int* const p1_tables[NUM_PIECE_TYPES - 1] = {
+        PST_RAT_P1, PST_CAT_P1, PST_DOG_P1, PST_WOLF_P1, PST_PANTHER_P1, PST_TIGER_P1, PST_LION_P1, PST_ELEPHANT_P1
+    };
+    const int* const p2_tables[NUM_PIECE_TYPES - 1] = {
+        PST_RAT_P2, PST_CAT_P2, PST_DOG_P2, PST_WOLF_P2, PST_PANTHER_P2, PST_TIGER_P2, PST_LION_P2, PST_ELEPHANT_P2
+    };
+
+    for (int pt = RAT; pt < NUM_PIECE_TYPES; ++pt) {
+        for (int sq = 0; sq < NUM_SQUARES; ++sq) {
+            PIECE_SQUARE_VALUES[pt][PLAYER_1][sq] = PIECE_VALUES[pt] + p1_tables[pt - 1][sq];
+            PIECE_SQUARE_VALUES[pt][PLAYER_2][sq] = PIECE_VALUES[pt] + p2_tables[pt - 1][sq];
+        }
+    }
+}
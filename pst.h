@@ -29,8 +29,14 @@ extern const int PST_TIGER_P2[NUM_SQUARES];
 extern const int PST_LION_P2[NUM_SQUARES];
 extern const int PST_ELEPHANT_P2[NUM_SQUARES];
 
-// Helper function to initialize all PSTs (if needed, or they can be const initialized)
-// For now, they will be const initialized directly in pst.cpp
-// void init_psts(); 
+// Combined material + PST value of a piece for its owner, indexed like Zobrist::piece_keys:
+// PIECE_SQUARE_VALUES[piece_type][player][square] = PIECE_VALUES[piece_type] + PST_<TYPE>_P<player>[square].
+// Rows for NO_PIECE_TYPE and NO_PLAYER stay 0. BoardState keeps a running sum of these per player,
+// so evaluation never has to walk the bitboards.
+extern int PIECE_SQUARE_VALUES[NUM_PIECE_TYPES][3][NUM_SQUARES];
+
+// Fills PIECE_SQUARE_VALUES from PIECE_VALUES and the per-piece tables above.
+// Must be called once at startup, before any board is set up or loaded.
+void init_psts(); 
 
 #endif // PST_H
\ No newline at end of file
@@ -0,0 +1,63 @@
+// bbdsq/repetition.cpp
+#include "repetition.h"
+
+RepetitionStack::RepetitionStack() {
+    keys.reserve(MAX_SEARCH_PLY);
+    reversible_start.reserve(MAX_SEARCH_PLY);
+}
+
+RepetitionStack::RepetitionStack(const RepetitionStack& other) {
+    *this = other;
+}
+
+RepetitionStack& RepetitionStack::operator=(const RepetitionStack& other) {
+    if (this != &other) {
+        keys.reserve(other.keys.size() + MAX_SEARCH_PLY);
+        reversible_start.reserve(other.reversible_start.size() + MAX_SEARCH_PLY);
+        keys = other.keys;
+        reversible_start = other.reversible_start;
+    }
+    return *this;
+}
+
+void RepetitionStack::reset_from_game_history(const std::vector<PackedPosition>& game_history, int last_index) {
+    int history_size = static_cast<int>(game_history.size());
+    if (last_index < 0 || last_index >= history_size) {
+        last_index = history_size - 1;
+    }
+
+    keys.clear();
+    reversible_start.clear();
+    // Reserve once for the game plus a full search path, so push() never reallocates in the search.
+    keys.reserve(last_index + 1 + MAX_SEARCH_PLY);
+    reversible_start.reserve(last_index + 1 + MAX_SEARCH_PLY);
+
+    for (int i = 0; i <= last_index; ++i) {
+        // Piece counts only ever go down, so a drop marks a capture between the two states.
+        bool irreversible = (i > 0) && game_history[i].piece_count() < game_history[i - 1].piece_count();
+        push(game_history[i].hash(), irreversible);
+    }
+}
+
+void RepetitionStack::push(U64 zobrist_key, bool irreversible) {
+    int index = size();
+    keys.push_back(zobrist_key);
+    reversible_start.push_back((irreversible || index == 0) ? index : reversible_start[index - 1]);
+}
+
+void RepetitionStack::pop() {
+    if (!keys.empty()) {
+        keys.pop_back();
+        reversible_start.pop_back();
+    }
+}
+
+int RepetitionStack::count(U64 zobrist_key) const {
+    if (keys.empty()) return 0;
+    int occurrences = 0;
+    int stop = reversible_start.back();
+    for (int i = size() - 1; i >= stop; --i) {
+        if (keys[i] == zobrist_key) occurrences++;
+    }
+    return occurrences;
+}
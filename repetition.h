@@ -0,0 +1,41 @@
+// bbdsq/repetition.h
+#ifndef REPETITION_H
+#define REPETITION_H
+
+#include "bitboard.h" // For U64
+#include "packed_position.h" // For PackedPosition (building the stack from the game history)
+#include <vector>
+
+// Stack of Zobrist keys of every position reached so far: the game history first,
+// followed by the positions on the current search path. The search pushes a key after
+// make_move() and pops it before unmake_move(), so repetition checks never copy histories.
+struct RepetitionStack {
+    // Extra room reserved on top of the game history for the search path.
+    static const int MAX_SEARCH_PLY = 512;
+
+    RepetitionStack();
+    // Copies keep the search headroom reserved (each search thread works on its own copy).
+    RepetitionStack(const RepetitionStack& other);
+    RepetitionStack& operator=(const RepetitionStack& other);
+
+    // Rebuilds the stack from a game history (oldest first). Only the states up to and
+    // including 'last_index' are used, so redo states after an undo are not counted.
+    // last_index < 0 means "the whole history".
+    void reset_from_game_history(const std::vector<PackedPosition>& game_history, int last_index = -1);
+
+    // 'irreversible' marks a position reached by a capture: no earlier position can ever
+    // occur again, so count() stops scanning there.
+    void push(U64 zobrist_key, bool irreversible);
+    void pop();
+
+    // Number of times 'zobrist_key' occurs since (and including) the last irreversible position.
+    int count(U64 zobrist_key) const;
+
+    int size() const { return static_cast<int>(keys.size()); }
+
+private:
+    std::vector<U64> keys;
+    std::vector<int> reversible_start; // For each entry: index of the last irreversible entry at or below it
+};
+
+#endif // REPETITION_H
@@ -1,126 +1,420 @@
 // bbdsq/ttable.cpp
 #include "ttable.h"
+#include "zobrist.h" // For KEY_SEED (snapshot header)
 #include <vector>
 #include <iostream> // For messages
 #include <cstring>  // For std::memset (though not used if default constructing entries)
 #include <algorithm>// For std::fill_n if used for clearing
+#include <atomic>   // For lockless slot words
+#include <new>      // For std::nothrow
+#include <fstream>  // For the snapshot file and reading the huge page state from /sys and /proc
+#include <string>
+#include <cstdio>   // For std::sscanf
+
+#if defined(__linux__)
+#include <sys/mman.h> // For mmap/madvise
+#endif
 
 namespace TranspositionTable {
 
+    // --- Packed Entry Layout (16 bytes) ---
+    // data:     move(16) | score(32) | depth(8) | flag(2) | generation(6)
+    // key_xor:  zobrist_key ^ data
+    // move:     from_sq(6) | to_sq(6) | piece_moved(4); 0 is the null move (from == to never
+    //           happens for a real move). The captured piece is not stored, see TTEntry.
+    // Both words are read and written with relaxed atomics: a reader may see words from two
+    // different stores, but then the XOR check fails and the slot is treated as a miss.
+    // The key check is the full 64-bit key, recovered for free from the XOR.
+    struct TTSlot {
+        std::atomic<U64> key_xor_data;
+        std::atomic<U64> data;
+    };
+    static_assert(sizeof(TTSlot) == 16, "TTSlot must stay packed to 16 bytes");
+
+    // --- Cluster Layout ---
+    // One 64-byte cache line holds all the slots a hash can map to, so a probe or store
+    // touches exactly one line (and prefetch_tt can fetch it ahead of time).
+    const int CLUSTER_SIZE = 4;
+    struct alignas(64) TTCluster {
+        TTSlot slots[CLUSTER_SIZE];
+    };
+    static_assert(sizeof(TTCluster) == 64, "TTCluster must fill exactly one cache line");
+
+    const int GENERATION_BITS = 6;
+    const uint8_t GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+    static uint16_t pack_move(const Move& move) {
+        if (move.from_sq < 0 || move.to_sq < 0) return 0;
+        return static_cast<uint16_t>(move.from_sq |
+                                     (move.to_sq << 6) |
+                                     (static_cast<int>(move.piece_moved) << 12));
+    }
+
+    static Move unpack_move(uint16_t packed) {
+        if (packed == 0) return Move();
+        return Move(packed & 0x3F, (packed >> 6) & 0x3F, static_cast<PieceType>(packed >> 12));
+    }
+
+    static U64 pack_data(uint16_t packed_move, int score, int depth, EntryFlag flag, uint8_t generation) {
+        return static_cast<U64>(packed_move) |
+               (static_cast<U64>(static_cast<uint32_t>(score)) << 16) |
+               (static_cast<U64>(static_cast<uint8_t>(static_cast<int8_t>(depth))) << 48) |
+               (static_cast<U64>(static_cast<uint8_t>(flag) & 0x3) << 56) |
+               (static_cast<U64>(generation & GENERATION_MASK) << 58);
+    }
+
+    static uint16_t data_move(U64 data) {
+        return static_cast<uint16_t>(data);
+    }
+
+    static int data_depth(U64 data) {
+        return static_cast<int8_t>(static_cast<uint8_t>(data >> 48));
+    }
+
+    static EntryFlag data_flag(U64 data) {
+        return static_cast<EntryFlag>((data >> 56) & 0x3);
+    }
+
+    static uint8_t data_generation(U64 data) {
+        return static_cast<uint8_t>(data >> 58) & GENERATION_MASK;
+    }
+
+    static void unpack_entry(U64 zobrist_hash, U64 data, TTEntry& entry) {
+        entry.zobrist_key_check = zobrist_hash;
+        entry.best_move = unpack_move(data_move(data));
+        entry.score = static_cast<int32_t>(static_cast<uint32_t>(data >> 16));
+        entry.depth = static_cast<short>(data_depth(data));
+        entry.flag = data_flag(data);
+    }
+
     // --- Transposition Table Data ---
-    static std::vector<TTEntry> tt_table; 
-    static size_t tt_num_entries = 0;     
+    static TTCluster* tt_table = nullptr; 
+    static size_t tt_num_clusters = 0;     // Always a power of two (or 0)
+    static size_t tt_cluster_mask = 0;     // tt_num_clusters - 1
+    static size_t tt_num_entries = 0;      // tt_num_clusters * CLUSTER_SIZE
     static bool tt_initialized = false;
+    static uint8_t tt_generation = 0;      // Bumped by new_search() (mod 64); only changes between searches
+
+    static TTCluster& cluster_for(U64 zobrist_hash) {
+        return tt_table[zobrist_hash & tt_cluster_mask];
+    }
+
+    // --- Statistics ---
+    // Counted per thread in plain integers, so the hot path never writes a shared cache line,
+    // and folded into the shared totals by flush_thread_stats() when a search thread finishes.
+    // Probe/store totals cover the current search generation; used entries cover the table's
+    // lifetime since it was initialized.
+    struct TTCounters {
+        U64 probes;
+        U64 hits;
+        U64 cluster_misses; // Missed probes in an occupied cluster
+        U64 stores;
+        U64 replacements;
+        U64 filled; // Stores into an empty slot
+
+        TTCounters() : probes(0), hits(0), cluster_misses(0), stores(0), replacements(0), filled(0) {}
+    };
+    static thread_local TTCounters thread_counters;
+
+    static std::atomic<U64> total_probes(0);
+    static std::atomic<U64> total_hits(0);
+    static std::atomic<U64> total_cluster_misses(0);
+    static std::atomic<U64> total_stores(0);
+    static std::atomic<U64> total_replacements(0);
+    static std::atomic<U64> total_used_entries(0);
+
+    // hashfull is sampled over this many clusters at the start of the table.
+    const size_t HASHFULL_SAMPLE_CLUSTERS = 250;
+
+    static void reset_search_counters() {
+        total_probes.store(0, std::memory_order_relaxed);
+        total_hits.store(0, std::memory_order_relaxed);
+        total_cluster_misses.store(0, std::memory_order_relaxed);
+        total_stores.store(0, std::memory_order_relaxed);
+        total_replacements.store(0, std::memory_order_relaxed);
+    }
+
+    // --- Table Memory ---
+    // On Linux the table is an anonymous mmap: the kernel hands out zero pages on first touch,
+    // so allocation is instant at any size. The table is aligned to 2 MB and marked MADV_HUGEPAGE
+    // so transparent huge pages can back it, which cuts TLB misses on the random probes.
+    // Elsewhere it is a value-initialized (zeroed) array.
+    const size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+    static void* tt_memory_base = nullptr;  // What was mapped (the table starts at the aligned point inside)
+    static size_t tt_memory_bytes = 0;
+    static bool tt_memory_mapped = false;
+    static bool tt_huge_pages_requested = false;
+
+    // Returns the bracketed transparent huge page mode ("always", "madvise", "never"),
+    // or an empty string if the kernel does not expose it.
+    static std::string transparent_huge_page_mode() {
+        std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line;
+        if (!in || !std::getline(in, line)) return "";
+        size_t open = line.find('[');
+        size_t close = line.find(']', open);
+        if (open == std::string::npos || close == std::string::npos) return "";
+        return line.substr(open + 1, close - open - 1);
+    }
+
+    static bool allocate_table(size_t num_clusters) {
+        size_t table_bytes = num_clusters * sizeof(TTCluster);
+#if defined(__linux__)
+        size_t rounded_bytes = (table_bytes + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+        size_t map_bytes = rounded_bytes + HUGE_PAGE_BYTES; // Slack to align the start
+        void* base = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED) {
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(base) + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1);
+            tt_memory_base = base;
+            tt_memory_bytes = map_bytes;
+            tt_memory_mapped = true;
+#if defined(MADV_HUGEPAGE)
+            tt_huge_pages_requested = (madvise(reinterpret_cast<void*>(aligned), rounded_bytes, MADV_HUGEPAGE) == 0);
+#endif
+            // Zero-filled memory is a valid table (every slot decodes as NO_ENTRY) and the
+            // atomics are trivially constructible, so no constructor pass is needed.
+            tt_table = reinterpret_cast<TTCluster*>(aligned);
+            return true;
+        }
+#endif
+        tt_table = new (std::nothrow) TTCluster[num_clusters](); // () zero-initializes every slot
+        tt_memory_base = tt_table;
+        tt_memory_bytes = table_bytes;
+        tt_memory_mapped = false;
+        tt_huge_pages_requested = false;
+        return tt_table != nullptr;
+    }
+
+    static void release_table() {
+#if defined(__linux__)
+        if (tt_memory_mapped) {
+            munmap(tt_memory_base, tt_memory_bytes);
+        } else {
+            delete[] tt_table;
+        }
+#else
+        delete[] tt_table;
+#endif
+        tt_table = nullptr;
+        tt_memory_base = nullptr;
+        tt_memory_bytes = 0;
+        tt_memory_mapped = false;
+        tt_huge_pages_requested = false;
+    }
+
+    // Bytes of the table currently backed by transparent huge pages, from /proc/self/smaps.
+    // Pages are only faulted in as entries are written, so this grows as the table fills.
+    static size_t huge_page_backed_bytes() {
+#if defined(__linux__)
+        if (!tt_memory_mapped) return 0;
+        std::ifstream smaps("/proc/self/smaps");
+        std::string line;
+        uintptr_t table_start = reinterpret_cast<uintptr_t>(tt_table);
+        bool in_table_mapping = false;
+        while (std::getline(smaps, line)) {
+            unsigned long long start = 0, end = 0;
+            if (std::sscanf(line.c_str(), "%llx-%llx ", &start, &end) == 2) {
+                in_table_mapping = (table_start >= start && table_start < end);
+                continue;
+            }
+            unsigned long long kb = 0;
+            if (in_table_mapping && std::sscanf(line.c_str(), "AnonHugePages: %llu kB", &kb) == 1) {
+                return static_cast<size_t>(kb) * 1024;
+            }
+        }
+#endif
+        return 0;
+    }
 
     // --- Transposition Table Management ---
 
     void initialize_tt(size_t size_mb) {
         if (size_mb == 0) {
+            tt_num_clusters = 0;
+            tt_cluster_mask = 0;
             tt_num_entries = 0;
-            tt_table.clear(); // Ensure vector is empty
-            tt_table.shrink_to_fit(); // Release memory
+            release_table(); // Release memory
             tt_initialized = false;
             std::cout << "Transposition Table disabled (size 0 MB)." << std::endl;
             return;
         }
 
         size_t table_size_bytes = size_mb * 1024 * 1024;
-        size_t calculated_num_entries = table_size_bytes / sizeof(TTEntry);
+        size_t max_clusters = table_size_bytes / sizeof(TTCluster);
 
-        if (calculated_num_entries == 0 && size_mb > 0) { 
-            calculated_num_entries = 1; 
-            std::cout << "Warning: TT size in MB is too small for even one entry. Setting to 1 entry." << std::endl;
+        // Largest power of two that fits, so the cluster index is a mask instead of a 64-bit modulo.
+        size_t calculated_num_clusters = 1;
+        while (calculated_num_clusters * 2 <= max_clusters) {
+            calculated_num_clusters *= 2;
         }
+        tt_num_clusters = calculated_num_clusters;
+        tt_cluster_mask = tt_num_clusters - 1;
+        tt_num_entries = tt_num_clusters * CLUSTER_SIZE;
         
-        // For efficient modulo indexing, powers of 2 are good, but not strictly necessary with %.
-        // If we wanted to use bitwise AND for indexing (hash & (num_entries - 1)),
-        // num_entries would need to be a power of 2.
-        // For now, tt_num_entries can be any value.
-        tt_num_entries = calculated_num_entries;
-        
-        try {
-            // If re-initializing, clear old table first to free memory before resize
-            if (tt_initialized) {
-                tt_table.clear();
-                tt_table.shrink_to_fit();
-            }
-            tt_table.resize(tt_num_entries); 
-            clear_tt(); 
-            tt_initialized = true;
-            std::cout << "Transposition Table initialized. Target Size: " << size_mb << " MB, Actual Entries: " << tt_num_entries 
-                      << " (Entry size: " << sizeof(TTEntry) << " bytes)" << std::endl;
-        } catch (const std::bad_alloc& e) {
-            std::cerr << "Error: Failed to allocate memory for Transposition Table (" << size_mb << " MB). "
-                      << e.what() << std::endl;
-            tt_num_entries = 0;
-            tt_table.clear();
-            tt_initialized = false;
-        } catch (const std::exception& e) { // Catch other potential exceptions from resize/vector ops
-            std::cerr << "Error during TT initialization: " << e.what() << std::endl;
+        // If re-initializing, free the old table first so both never exist at once
+        if (tt_table != nullptr) {
+            release_table();
+        }
+        if (!allocate_table(tt_num_clusters)) {
+            std::cerr << "Error: Failed to allocate memory for Transposition Table (" << size_mb << " MB)." << std::endl;
+            tt_num_clusters = 0;
+            tt_cluster_mask = 0;
             tt_num_entries = 0;
-            tt_table.clear();
             tt_initialized = false;
+            return;
         }
-    }
+        tt_initialized = true;
+        // The new memory is already zero; only the counters need resetting.
+        tt_generation = 0;
+        thread_counters = TTCounters();
+        reset_search_counters();
+        total_used_entries.store(0, std::memory_order_relaxed);
 
-    void clear_tt() {
-        if (!tt_initialized || tt_num_entries == 0 || tt_table.empty()) return;
-        // Using default constructor for each TTEntry is safer than memset
-        // as it correctly initializes flags and other members.
-        for (size_t i = 0; i < tt_num_entries; ++i) {
-            tt_table[i] = TTEntry(); 
+        std::cout << "Transposition Table initialized. Target Size: " << size_mb << " MB, Actual Entries: " << tt_num_entries 
+                  << " in " << tt_num_clusters << " clusters (" << tt_num_clusters * sizeof(TTCluster) / (1024 * 1024) << " MB used, "
+                  << "Entry size: " << sizeof(TTSlot) << " bytes)" << std::endl;
+        if (tt_huge_pages_requested) {
+            std::string thp_mode = transparent_huge_page_mode();
+            if (thp_mode == "never") {
+                std::cout << "Transposition Table huge pages: requested, but transparent huge pages are disabled on this system." << std::endl;
+            } else {
+                std::cout << "Transposition Table huge pages: requested (THP mode: " << (thp_mode.empty() ? "unknown" : thp_mode) << ")." << std::endl;
+            }
+        } else {
+            std::cout << "Transposition Table huge pages: not available, using normal pages." << std::endl;
         }
-        // Alternative using std::fill_n if TTEntry() is cheap and well-defined for this
-        // std::fill_n(tt_table.begin(), tt_num_entries, TTEntry());
-        // std::cout << "Transposition Table cleared (" << tt_num_entries << " entries reset)." << std::endl;
     }
 
-    TTEntry* probe_tt(U64 zobrist_hash) {
-        if (!tt_initialized || tt_num_entries == 0) {
-            return nullptr;
+    void new_search() {
+        tt_generation = (tt_generation + 1) & GENERATION_MASK;
+        reset_search_counters();
+    }
+
+    void flush_thread_stats() {
+        total_probes.fetch_add(thread_counters.probes, std::memory_order_relaxed);
+        total_hits.fetch_add(thread_counters.hits, std::memory_order_relaxed);
+        total_cluster_misses.fetch_add(thread_counters.cluster_misses, std::memory_order_relaxed);
+        total_stores.fetch_add(thread_counters.stores, std::memory_order_relaxed);
+        total_replacements.fetch_add(thread_counters.replacements, std::memory_order_relaxed);
+        total_used_entries.fetch_add(thread_counters.filled, std::memory_order_relaxed);
+        thread_counters = TTCounters();
+    }
+
+    void prefetch_tt(U64 zobrist_hash) {
+        if (!tt_initialized) return;
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&cluster_for(zobrist_hash));
+#else
+        (void)zobrist_hash;
+#endif
+    }
+
+    bool probe_tt(U64 zobrist_hash, TTEntry& entry_out) {
+        if (!tt_initialized || tt_num_clusters == 0) {
+            return false;
         }
 
-        size_t index = zobrist_hash % tt_num_entries; 
-        TTEntry* entry = &tt_table[index];
+        thread_counters.probes++;
+        TTCluster& cluster = cluster_for(zobrist_hash);
+        bool rejected_by_key_check = false;
+        for (TTSlot& slot : cluster.slots) {
+            U64 data = slot.data.load(std::memory_order_relaxed);
+            U64 key_xor_data = slot.key_xor_data.load(std::memory_order_relaxed);
 
-        if (entry->flag != EntryFlag::NO_ENTRY && entry->zobrist_key_check == zobrist_hash) {
-            return entry;
+            if (data_flag(data) == EntryFlag::NO_ENTRY) {
+                continue;
+            }
+            // Other position sharing this cluster (an index collision the key check caught),
+            // or words from two different stores (torn): not usable.
+            if ((key_xor_data ^ data) != zobrist_hash) {
+                rejected_by_key_check = true;
+                continue;
+            }
+            unpack_entry(zobrist_hash, data, entry_out);
+            thread_counters.hits++;
+            return true;
         }
-        
-        return nullptr; 
+        // Counted once per probe, and only for misses: a probe that finds its own entry further
+        // along the cluster did not suffer from the other positions stored there.
+        if (rejected_by_key_check) {
+            thread_counters.cluster_misses++;
+        }
+        return false; 
     }
 
     void store_tt_entry(U64 zobrist_hash, int score, int depth, EntryFlag flag, const Move& best_move) {
-        if (!tt_initialized || tt_num_entries == 0) {
+        if (!tt_initialized || tt_num_clusters == 0) {
             return;
         }
 
-        size_t index = zobrist_hash % tt_num_entries;
-        TTEntry* entry_to_replace = &tt_table[index];
+        TTCluster& cluster = cluster_for(zobrist_hash);
 
         // Replacement strategy:
-        // Overwrite if:
-        // 1. Slot is empty.
-        // 2. Existing entry is for a different position (hash mismatch).
-        // 3. New entry is from a deeper or equally deep search.
-        //    (If same depth, new entry might be more accurate, e.g. EXACT vs BOUND)
-        // A common strategy is "depth-preferred replacement".
-        if (entry_to_replace->flag == EntryFlag::NO_ENTRY || 
-            entry_to_replace->zobrist_key_check != zobrist_hash || 
-            depth >= entry_to_replace->depth) // Replace if new entry is deeper or same depth
-                                              // (could add tie-breaking like preferring EXACT scores)
-        {
-            entry_to_replace->zobrist_key_check = zobrist_hash;
-            entry_to_replace->score = score;
-            entry_to_replace->depth = static_cast<short>(depth);
-            entry_to_replace->flag = flag;
-            entry_to_replace->best_move = best_move; 
+        // 1. The slot already holding this position is updated, unless it has a deeper result
+        //    from the current search (a result from an older search is always refreshed).
+        //    Its best move is kept if the new result has none.
+        // 2. Otherwise an empty slot is used.
+        // 3. Otherwise the least valuable slot is replaced: shallow entries and entries from
+        //    older searches go first (each search of age counts like 4 plies of depth).
+        // A torn slot fails the key check and competes as a replacement candidate.
+        TTSlot* target = nullptr;
+        bool target_is_empty = false;
+        bool target_is_same_position = false;
+        uint16_t move_to_store = pack_move(best_move);
+        int worst_value = 0;
+
+        for (TTSlot& slot : cluster.slots) {
+            U64 old_data = slot.data.load(std::memory_order_relaxed);
+            U64 old_key_xor = slot.key_xor_data.load(std::memory_order_relaxed);
+
+            if (data_flag(old_data) == EntryFlag::NO_ENTRY) {
+                if (!target_is_empty) {
+                    target = &slot;
+                    target_is_empty = true; // Empty slots beat any occupied victim
+                }
+                continue;
+            }
+
+            if ((old_key_xor ^ old_data) == zobrist_hash) {
+                if (data_generation(old_data) == tt_generation && depth < data_depth(old_data)) {
+                    return; // Keep the deeper result for this position
+                }
+                if (move_to_store == 0) {
+                    move_to_store = data_move(old_data);
+                }
+                target = &slot;
+                target_is_empty = false;
+                target_is_same_position = true;
+                break;
+            }
+
+            if (target_is_empty) {
+                continue;
+            }
+            int age = (tt_generation - data_generation(old_data)) & GENERATION_MASK;
+            int value = data_depth(old_data) - 4 * age;
+            if (target == nullptr || value < worst_value) {
+                target = &slot;
+                worst_value = value;
+            }
+        }
+
+        thread_counters.stores++;
+        if (target_is_empty) {
+            thread_counters.filled++;
+        } else if (!target_is_same_position) {
+            thread_counters.replacements++;
         }
+
+        U64 data = pack_data(move_to_store, score, depth, flag, tt_generation);
+        target->data.store(data, std::memory_order_relaxed);
+        target->key_xor_data.store(zobrist_hash ^ data, std::memory_order_relaxed);
     }
     
     void cleanup_tt() {
-        tt_table.clear();
-        tt_table.shrink_to_fit(); 
+        release_table(); 
+        tt_num_clusters = 0;
+        tt_cluster_mask = 0;
         tt_num_entries = 0;
         tt_initialized = false;
         // std::cout << "Transposition Table cleaned up." << std::endl;
@@ -137,18 +431,157 @@ namespace TranspositionTable {
             return stats; 
         }
 
-        for (size_t i = 0; i < tt_num_entries; ++i) {
-            if (tt_table[i].flag != EntryFlag::NO_ENTRY) {
-                stats.used_entries++;
+        // Two threads filling the same empty slot at once both count it; clamp the rare overshoot.
+        stats.used_entries = std::min(static_cast<size_t>(total_used_entries.load(std::memory_order_relaxed)),
+                                      stats.total_entries);
+        stats.utilization_percent = (static_cast<double>(stats.used_entries) / stats.total_entries) * 100.0;
+
+        size_t sample_clusters = std::min(HASHFULL_SAMPLE_CLUSTERS, tt_num_clusters);
+        size_t sample_current = 0;
+        for (size_t i = 0; i < sample_clusters; ++i) {
+            for (const TTSlot& slot : tt_table[i].slots) {
+                U64 data = slot.data.load(std::memory_order_relaxed);
+                if (data_flag(data) != EntryFlag::NO_ENTRY && data_generation(data) == tt_generation) {
+                    sample_current++;
+                }
             }
         }
+        stats.hashfull_permille = static_cast<int>(sample_current * 1000 / (sample_clusters * CLUSTER_SIZE));
 
-        if (stats.total_entries > 0) {
-            stats.utilization_percent = (static_cast<double>(stats.used_entries) / stats.total_entries) * 100.0;
+        stats.probes = total_probes.load(std::memory_order_relaxed);
+        stats.probe_hits = total_hits.load(std::memory_order_relaxed);
+        stats.cluster_misses = total_cluster_misses.load(std::memory_order_relaxed);
+        stats.stores = total_stores.load(std::memory_order_relaxed);
+        stats.replacements = total_replacements.load(std::memory_order_relaxed);
+        if (stats.probes > 0) {
+            stats.hit_rate_percent = (static_cast<double>(stats.probe_hits) / stats.probes) * 100.0;
         }
         return stats;
     }
 
-} // namespace TranspositionTable
+    size_t get_tt_huge_page_bytes() {
+        return huge_page_backed_bytes();
+    }
+
+    // --- Snapshot File ---
+    // Header, then one (key, data) pair of U64 per non-empty slot. The key is recovered from
+    // the slot's key_xor_data ^ data, so a record is independent of the table size.
+    const char SNAPSHOT_MAGIC[8] = {'B', 'B', 'D', 'S', 'Q', 'T', 'T', '\0'};
+    const uint32_t SNAPSHOT_FORMAT_VERSION = 2;   // Bump whenever the data word layout or score meaning changes
+                                                  // (2: scores relative to the side to move)
+    const uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+    const size_t SNAPSHOT_BUFFER_RECORDS = 65536; // Records per write/read call
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint32_t format_version;
+        uint32_t byte_order_mark;
+        U64 zobrist_seed;
+        U64 record_count;
+    };
 
+    bool save_tt_snapshot(const std::string& filename) {
+        if (!tt_initialized || tt_num_clusters == 0) return false;
 
+        std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Could not open TT snapshot file for writing: " << filename << std::endl;
+            return false;
+        }
+
+        SnapshotHeader header;
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.format_version = SNAPSHOT_FORMAT_VERSION;
+        header.byte_order_mark = SNAPSHOT_BYTE_ORDER_MARK;
+        header.zobrist_seed = Zobrist::KEY_SEED;
+        header.record_count = 0; // Patched once the records are written
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<U64> buffer;
+        buffer.reserve(SNAPSHOT_BUFFER_RECORDS * 2);
+        for (size_t i = 0; i < tt_num_clusters && out; ++i) {
+            for (const TTSlot& slot : tt_table[i].slots) {
+                U64 data = slot.data.load(std::memory_order_relaxed);
+                if (data_flag(data) == EntryFlag::NO_ENTRY) continue;
+                buffer.push_back(slot.key_xor_data.load(std::memory_order_relaxed) ^ data);
+                buffer.push_back(data);
+            }
+            if (buffer.size() >= SNAPSHOT_BUFFER_RECORDS * 2) {
+                out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(U64));
+                header.record_count += buffer.size() / 2;
+                buffer.clear();
+            }
+        }
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(U64));
+        header.record_count += buffer.size() / 2;
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!out) {
+            std::cerr << "Error: Failed while writing TT snapshot file: " << filename << std::endl;
+            return false;
+        }
+        std::cout << "Transposition Table snapshot saved: " << header.record_count << " entries to " << filename << std::endl;
+        return true;
+    }
+
+    bool load_tt_snapshot(const std::string& filename) {
+        if (!tt_initialized || tt_num_clusters == 0) return false;
+
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            return false; // No snapshot yet: not an error
+        }
+
+        SnapshotHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << "Warning: " << filename << " is not a TT snapshot, ignored." << std::endl;
+            return false;
+        }
+        // Byte order first: with the wrong one, the other fields cannot be read either.
+        if (header.byte_order_mark != SNAPSHOT_BYTE_ORDER_MARK) {
+            std::cerr << "Warning: TT snapshot " << filename << " was written on a machine with another byte order, ignored." << std::endl;
+            return false;
+        }
+        if (header.format_version != SNAPSHOT_FORMAT_VERSION) {
+            std::cerr << "Warning: TT snapshot " << filename << " was written by an incompatible version "
+                      << "(format " << header.format_version << ", expected " << SNAPSHOT_FORMAT_VERSION << "), ignored." << std::endl;
+            return false;
+        }
+        if (header.zobrist_seed != Zobrist::KEY_SEED) {
+            std::cerr << "Warning: TT snapshot " << filename << " was written with other Zobrist keys "
+                      << "(seed 0x" << std::hex << header.zobrist_seed << ", expected 0x" << Zobrist::KEY_SEED << std::dec
+                      << "), ignored." << std::endl;
+            return false;
+        }
+
+        // Entries go through the normal store path, so the replacement policy decides what
+        // survives when the snapshot holds more entries than the table has room for.
+        U64 loaded = 0;
+        std::vector<U64> buffer(SNAPSHOT_BUFFER_RECORDS * 2);
+        while (loaded < header.record_count) {
+            U64 batch = std::min<U64>(SNAPSHOT_BUFFER_RECORDS, header.record_count - loaded);
+            if (!in.read(reinterpret_cast<char*>(buffer.data()), batch * 2 * sizeof(U64))) {
+                std::cerr << "Warning: TT snapshot " << filename << " is truncated; loaded "
+                          << loaded << " of " << header.record_count << " entries." << std::endl;
+                break;
+            }
+            for (U64 r = 0; r < batch; ++r) {
+                U64 key = buffer[r * 2];
+                U64 data = buffer[r * 2 + 1];
+                EntryFlag flag = data_flag(data);
+                if (flag == EntryFlag::NO_ENTRY) continue;
+                store_tt_entry(key, static_cast<int32_t>(static_cast<uint32_t>(data >> 16)), data_depth(data),
+                               flag, unpack_move(data_move(data)));
+            }
+            loaded += batch;
+        }
+
+        flush_thread_stats();
+        reset_search_counters(); // The loading stores are not search statistics
+        std::cout << "Transposition Table snapshot loaded: " << loaded << " entries from " << filename << std::endl;
+        return loaded > 0;
+    }
+
+} // namespace TranspositionTable
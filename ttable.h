@@ -4,6 +4,7 @@
 
 #include "bitboard.h" // For U64
 #include "movegen.h"  // For Move struct 
+#include <string>     // For snapshot file names
                      // (Ensure Move struct is defined in movegen.h or its own move.h included by movegen.h)
 
 namespace TranspositionTable {
@@ -16,6 +17,10 @@ namespace TranspositionTable {
         UPPER_BOUND  
     };
 
+    // Decoded form of an entry, as handed to the search. The table itself stores entries
+    // packed into two atomic 64-bit words (16 bytes, see ttable.cpp), never this struct.
+    // best_move comes back with its squares and moving piece only (piece_captured is
+    // NO_PIECE_TYPE); match it against the legal moves with Move::same_squares.
     struct TTEntry {
         U64 zobrist_key_check; 
         Move best_move;        
@@ -36,26 +41,55 @@ namespace TranspositionTable {
 
     // Struct to hold TT statistics
     struct TTStats {
-        size_t used_entries;
+        size_t used_entries;          // Non-empty slots since initialization (any generation)
         size_t total_entries;
         double utilization_percent;
-
-        TTStats() : used_entries(0), total_entries(0), utilization_percent(0.0) {}
+        int hashfull_permille;        // Sampled share of slots written by the current search
+
+        // Counted since the last new_search(), over all search threads
+        unsigned long long probes;
+        unsigned long long probe_hits;
+        double hit_rate_percent;
+        unsigned long long cluster_misses; // Missed probes whose cluster held other positions
+        unsigned long long stores;
+        unsigned long long replacements;         // Stores that evicted a different position
+
+        TTStats() : used_entries(0), total_entries(0), utilization_percent(0.0), hashfull_permille(0),
+                    probes(0), probe_hits(0), hit_rate_percent(0.0), cluster_misses(0),
+                    stores(0), replacements(0) {}
     };
 
 
     // --- Transposition Table Management ---
 
+    // --- Layout ---
+    // Entries live in 64-byte, cache-line-aligned clusters of four; a hash selects one cluster
+    // (a power-of-two mask) and may use any slot in it.
+
+    // --- Concurrency ---
+    // The table is shared by all search threads without any lock. Each slot holds its data
+    // words plus the Zobrist key XOR-ed with them; a probe only accepts a slot whose words
+    // XOR back to the probed key, so an entry torn by a concurrent store is simply a miss.
+
     // Initializes the transposition table.
     // size_mb: desired table size in Megabytes.
+    // The memory comes from the OS already zeroed (mmap on Linux, with a huge page hint), so
+    // this returns immediately at any size; pages are only faulted in as entries are written.
     void initialize_tt(size_t size_mb);
 
-    // Clears all entries in the transposition table.
-    void clear_tt();
+    // Starts a new search generation. Entries from older generations are preferred
+    // victims for replacement. Call once per root search, before any thread starts; when
+    // the game changes (load, history divergence) stale entries are aged out the same way.
+    void new_search();
+
+    // Hints the CPU to fetch the cluster for this hash into cache. Call right after
+    // make_move so the line is loaded while the move loop does other work.
+    void prefetch_tt(U64 zobrist_hash);
 
     // Probes the TT for a given Zobrist hash.
-    // Returns a pointer to the TTEntry if found and valid, otherwise nullptr.
-    TTEntry* probe_tt(U64 zobrist_hash);
+    // Returns true and copies the entry into 'entry_out' if found and valid.
+    // (A copy, not a pointer: with several search threads the slot may be overwritten at any time.)
+    bool probe_tt(U64 zobrist_hash, TTEntry& entry_out);
 
     // Stores an entry into the transposition table.
     void store_tt_entry(U64 zobrist_hash, int score, int depth, EntryFlag flag, const Move& best_move);
@@ -67,9 +101,29 @@ namespace TranspositionTable {
     // Get current number of entries in TT (total capacity).
     size_t get_tt_num_entries();
 
-    // Gets current TT utilization statistics.
+    // Gets current TT utilization statistics. Cheap: occupancy comes from counters kept by
+    // the stores, and hashfull from a small sample at the start of the table.
     TTStats get_tt_stats();
 
+    // Bytes of the table currently backed by transparent huge pages (Linux only, else 0).
+    // Not cheap: it parses /proc/self/smaps, so it is not part of get_tt_stats().
+    size_t get_tt_huge_page_bytes();
+
+    // --- Snapshot File ---
+    // Writes every non-empty entry to 'filename' (binary, native byte order) behind a header
+    // holding the Zobrist key seed and the entry format version. Call with no search running.
+    // Returns true on success.
+    bool save_tt_snapshot(const std::string& filename);
+
+    // Stores the entries of a snapshot written by save_tt_snapshot into the current table
+    // (which may have a different size). Snapshots with another key seed or format version
+    // are rejected. Returns true if entries were loaded.
+    bool load_tt_snapshot(const std::string& filename);
+
+    // Adds the calling thread's probe/store counters to the shared totals. Each search thread
+    // calls this once when it finishes, before get_tt_stats() is read.
+    void flush_thread_stats();
+
 
 } // namespace TranspositionTable
 
@@ -14,7 +14,7 @@ namespace Zobrist {
         // Use a fixed seed for the pseudo-random number generator to ensure
         // that Zobrist keys are the same every time the program runs.
         // This is crucial for consistent hashing and for transposition tables if used later.
-        std::mt19937_64 rng(0xDEADBEEFCAFEBABEULL); // A fixed 64-bit seed
+        std::mt19937_64 rng(KEY_SEED); // A fixed 64-bit seed
         std::uniform_int_distribution<U64> distrib(0, std::numeric_limits<U64>::max());
 
         for (int pt_val = 0; pt_val < NUM_PIECE_TYPES; ++pt_val) {
@@ -61,7 +61,7 @@ namespace Zobrist {
             PieceType pt = static_cast<PieceType>(pt_val);
             for (int p_val = PLAYER_1; p_val <= PLAYER_2; ++p_val) { // Iterate actual players
                 Player player = static_cast<Player>(p_val);
-                U64 bb = board_state.piece_bbs[pt][player];
+                U64 bb = board_state.piece_bb(pt, player);
                 U64 temp_bb = bb;
                 while (temp_bb > 0) {
                     int sq = pop_lsb(temp_bb);
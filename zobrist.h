@@ -13,6 +13,10 @@
 
 namespace Zobrist {
 
+    // Seed of the key generator. Anything that persists hashes across runs (the TT snapshot)
+    // records it, so data made with different keys is never mistaken for a match.
+    const U64 KEY_SEED = 0xDEADBEEFCAFEBABEULL;
+
     // Zobrist keys:
     // piece_keys[piece_type_index][player_index][square_index]
     // Player index: 0 for NO_PLAYER (keys will be 0), 1 for PLAYER_1, 2 for PLAYER_2